@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <hyprtoolkit/element/Image.hpp>
+
+#include <hyprutils/math/Vector2D.hpp>
+#include <hyprutils/signal/Signal.hpp>
+
+#include "../helpers/Memory.hpp"
+
+class CDecodedImage;
+
+// The little hyprpaper needs from the toolkit: an event loop, the outputs, and a window
+// per output to stack images on. CToolkitBackend drives hyprtoolkit, the tests and the
+// bench drive a headless one with a virtual clock.
+
+class ITimer {
+  public:
+    virtual ~ITimer() = default;
+
+    virtual void cancel() = 0;
+    // fired already
+    virtual bool passed() = 0;
+};
+
+class IOutput {
+  public:
+    virtual ~IOutput() = default;
+
+    virtual const std::string&        port()      = 0;
+    virtual const std::string&        desc()      = 0;
+    virtual Hyprutils::Math::Vector2D pixelSize() = 0;
+    virtual uint32_t                  fps()       = 0;
+
+    struct {
+        Hyprutils::Signal::CSignalT<> removed;
+    } m_events;
+};
+
+// An image on a window, centered and drawn above everything added before it.
+// Positions are logical and relative to the centered spot.
+class IImageLayer {
+  public:
+    virtual ~IImageLayer() = default;
+
+    virtual void setImage(const SP<CDecodedImage>& image, Hyprtoolkit::eImageFitMode fitMode) = 0;
+    virtual void setAlpha(float alpha)                                                         = 0;
+    virtual void setPosition(const Hyprutils::Math::Vector2D& pos)                             = 0;
+};
+
+// A background layer covering one output. Every call is a redraw.
+class IWindow {
+  public:
+    virtual ~IWindow() = default;
+
+    virtual void            setBackground(uint32_t color)                                                                = 0;
+    virtual SP<IImageLayer> addImage(const SP<CDecodedImage>& image, Hyprtoolkit::eImageFitMode fitMode, float alpha) = 0;
+    virtual void            removeImage(const SP<IImageLayer>& layer)                                                    = 0;
+    // stays above the images, offset is from the bottom edge
+    virtual void            setSplash(const std::string& text, float offset, float alpha) = 0;
+    virtual float           scale()                                                       = 0;
+
+    struct {
+        // the output changed mode or scale, its pixelSize() may be different now
+        Hyprutils::Signal::CSignalT<> resized;
+    } m_events;
+};
+
+class IBackend {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    virtual ~IBackend() = default;
+
+    virtual SP<ITimer>               addTimer(Clock::duration timeout, std::function<void()>&& cb) = 0;
+    virtual void                     addIdle(std::function<void()>&& fn)                           = 0;
+    virtual void                     addFd(int fd, std::function<void()>&& cb)                     = 0;
+    virtual void                     removeFd(int fd)                                              = 0;
+    // what timers run against, use it instead of Clock::now()
+    virtual Clock::time_point        now() = 0;
+
+    virtual std::vector<SP<IOutput>> getOutputs()                            = 0;
+    virtual SP<IWindow>              createWindow(const SP<IOutput>& output) = 0;
+
+    virtual void                     enterLoop() = 0;
+
+    struct {
+        Hyprutils::Signal::CSignalT<SP<IOutput>> outputAdded;
+    } m_events;
+};
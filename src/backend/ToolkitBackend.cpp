@@ -0,0 +1,198 @@
+#include "ToolkitBackend.hpp"
+#include "../helpers/Logger.hpp"
+#include "../helpers/GlobalState.hpp"
+#include "../image/DecodedImage.hpp"
+
+#include <algorithm>
+
+#include <hyprtoolkit/core/Output.hpp>
+
+CToolkitTimer::CToolkitTimer(ASP<Hyprtoolkit::CTimer> timer) : m_timer(std::move(timer)) {
+    ;
+}
+
+void CToolkitTimer::cancel() {
+    m_timer->cancel();
+}
+
+bool CToolkitTimer::passed() {
+    return m_timer->passed();
+}
+
+CToolkitOutput::CToolkitOutput(SP<Hyprtoolkit::IOutput> output) : m_output(output), m_port(output->port()), m_desc(output->desc()) {
+    m_removed = output->m_events.removed.listen([this] { m_events.removed.emit(); });
+}
+
+const std::string& CToolkitOutput::port() {
+    return m_port;
+}
+
+const std::string& CToolkitOutput::desc() {
+    return m_desc;
+}
+
+Hyprutils::Math::Vector2D CToolkitOutput::pixelSize() {
+    const auto OUTPUT = m_output.lock();
+    return OUTPUT ? OUTPUT->pixelSize() : Hyprutils::Math::Vector2D{};
+}
+
+uint32_t CToolkitOutput::fps() {
+    const auto OUTPUT = m_output.lock();
+    return OUTPUT ? OUTPUT->fps() : 0;
+}
+
+static Hyprtoolkit::CDynamicSize fullSize() {
+    return {Hyprtoolkit::CDynamicSize::HT_SIZE_PERCENT, Hyprtoolkit::CDynamicSize::HT_SIZE_PERCENT, {1.F, 1.F}};
+}
+
+CToolkitImageLayer::CToolkitImageLayer(const SP<CDecodedImage>& image, Hyprtoolkit::eImageFitMode fitMode, float alpha) {
+    m_element = Hyprtoolkit::CImageBuilder::begin()->surface(image->surface())->size(fullSize())->fitMode(fitMode)->a(alpha)->commence();
+
+    m_element->setPositionMode(Hyprtoolkit::IElement::HT_POSITION_ABSOLUTE);
+    m_element->setPositionFlag(Hyprtoolkit::IElement::HT_POSITION_FLAG_CENTER, true);
+}
+
+void CToolkitImageLayer::setImage(const SP<CDecodedImage>& image, Hyprtoolkit::eImageFitMode fitMode) {
+    m_element->rebuild()->surface(image->surface())->size(fullSize())->fitMode(fitMode)->commence();
+}
+
+void CToolkitImageLayer::setAlpha(float alpha) {
+    // only the alpha is passed, the element keeps its surface and texture
+    m_element->rebuild()->a(alpha)->commence();
+}
+
+void CToolkitImageLayer::setPosition(const Hyprutils::Math::Vector2D& pos) {
+    m_element->setAbsolutePosition(pos);
+}
+
+CToolkitWindow::CToolkitWindow(WP<Hyprtoolkit::IBackend> backend, SP<Hyprtoolkit::IOutput> output) : m_backend(backend) {
+    m_window = Hyprtoolkit::CWindowBuilder::begin()
+                   ->type(Hyprtoolkit::HT_WINDOW_LAYER)
+                   ->prefferedOutput(output)
+                   ->anchor(0xF)
+                   ->layer(0)
+                   ->preferredSize({0, 0})
+                   ->exclusiveZone(-1)
+                   ->appClass("hyprpaper")
+                   ->commence();
+
+    m_bg   = Hyprtoolkit::CRectangleBuilder::begin()->size(fullSize())->color([] { return Hyprtoolkit::CHyprColor{0xFF000000}; })->commence();
+    m_null = Hyprtoolkit::CNullBuilder::begin()->size(fullSize())->commence();
+
+    m_window->m_rootElement->addChild(m_bg);
+    m_window->m_rootElement->addChild(m_null);
+
+    m_resized = m_window->m_events.resized.listen([this](Hyprutils::Math::Vector2D) { m_events.resized.emit(); });
+
+    m_window->open();
+}
+
+void CToolkitWindow::setBackground(uint32_t color) {
+    m_bg->rebuild()->size(fullSize())->color([color] { return Hyprtoolkit::CHyprColor{color}; })->commence();
+}
+
+SP<IImageLayer> CToolkitWindow::addImage(const SP<CDecodedImage>& image, Hyprtoolkit::eImageFitMode fitMode, float alpha) {
+    auto layer = makeShared<CToolkitImageLayer>(image, fitMode, alpha);
+    m_null->addChild(layer->m_element);
+    return layer;
+}
+
+void CToolkitWindow::removeImage(const SP<IImageLayer>& layer) {
+    // only ever handed layers we made
+    m_null->removeChild(sc<CToolkitImageLayer*>(layer.get())->m_element);
+}
+
+void CToolkitWindow::setSplash(const std::string& text, float offset, float alpha) {
+    if (m_splash)
+        m_window->m_rootElement->removeChild(m_splash);
+
+    m_splash = Hyprtoolkit::CTextBuilder::begin()
+                   ->text(std::string{text})
+                   ->fontSize({Hyprtoolkit::CFontSize::HT_FONT_TEXT, 1.15F})
+                   ->color([backend = m_backend] {
+                       const auto BACKEND = backend.lock();
+                       return BACKEND ? BACKEND->getPalette()->m_colors.text : Hyprtoolkit::CHyprColor{0xFFFFFFFF};
+                   })
+                   ->a(alpha)
+                   ->commence();
+    m_splash->setPositionMode(Hyprtoolkit::IElement::HT_POSITION_ABSOLUTE);
+    m_splash->setPositionFlag(Hyprtoolkit::IElement::HT_POSITION_FLAG_HCENTER, true);
+    m_splash->setPositionFlag(Hyprtoolkit::IElement::HT_POSITION_FLAG_BOTTOM, true);
+    m_splash->setAbsolutePosition({0.F, -offset});
+    // added after m_null, so it stays above the images
+    m_window->m_rootElement->addChild(m_splash);
+}
+
+float CToolkitWindow::scale() {
+    return m_window->scale();
+}
+
+SP<CToolkitBackend> CToolkitBackend::create() {
+    Hyprtoolkit::IBackend::SBackendCreationData data;
+    data.pLogConnection = makeShared<Hyprutils::CLI::CLoggerConnection>(*g_logger);
+    data.pLogConnection->setName("hyprtoolkit");
+    data.pLogConnection->setLogLevel(g_state->verbose ? LOG_TRACE : LOG_ERR);
+
+    const auto BACKEND = Hyprtoolkit::IBackend::createWithData(data);
+
+    if (!BACKEND)
+        return nullptr;
+
+    return SP<CToolkitBackend>(new CToolkitBackend(BACKEND));
+}
+
+CToolkitBackend::CToolkitBackend(SP<Hyprtoolkit::IBackend> backend) : m_backend(backend) {
+    m_outputAdded = m_backend->m_events.outputAdded.listen([this](SP<Hyprtoolkit::IOutput> output) { m_events.outputAdded.emit(wrap(output)); });
+}
+
+SP<ITimer> CToolkitBackend::addTimer(Clock::duration timeout, std::function<void()>&& cb) {
+    return makeShared<CToolkitTimer>(m_backend->addTimer(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(timeout), [cb = std::move(cb)](ASP<Hyprtoolkit::CTimer> self, void*) { cb(); }, nullptr));
+}
+
+void CToolkitBackend::addIdle(std::function<void()>&& fn) {
+    m_backend->addIdle(fn);
+}
+
+void CToolkitBackend::addFd(int fd, std::function<void()>&& cb) {
+    m_backend->addFd(fd, std::move(cb));
+}
+
+void CToolkitBackend::removeFd(int fd) {
+    m_backend->removeFd(fd);
+}
+
+IBackend::Clock::time_point CToolkitBackend::now() {
+    return Clock::now();
+}
+
+SP<CToolkitOutput> CToolkitBackend::wrap(const SP<Hyprtoolkit::IOutput>& output) {
+    // outputs which went away are dropped here rather than from their own removed event, listeners may still be running
+    std::erase_if(m_outputs, [](const auto& e) { return e->m_output.expired(); });
+
+    const auto IT = std::ranges::find_if(m_outputs, [&output](const auto& e) { return e->m_output.lock() == output; });
+
+    if (IT != m_outputs.end())
+        return *IT;
+
+    return m_outputs.emplace_back(makeShared<CToolkitOutput>(output));
+}
+
+std::vector<SP<IOutput>> CToolkitBackend::getOutputs() {
+    std::vector<SP<IOutput>> outputs;
+
+    for (const auto& o : m_backend->getOutputs()) {
+        outputs.emplace_back(wrap(o));
+    }
+
+    return outputs;
+}
+
+SP<IWindow> CToolkitBackend::createWindow(const SP<IOutput>& output) {
+    // only ever handed outputs we wrapped
+    return makeShared<CToolkitWindow>(m_backend, sc<CToolkitOutput*>(output.get())->m_output.lock());
+}
+
+void CToolkitBackend::enterLoop() {
+    m_backend->enterLoop();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <hyprtoolkit/core/Backend.hpp>
+#include <hyprtoolkit/core/Timer.hpp>
+#include <hyprtoolkit/window/Window.hpp>
+#include <hyprtoolkit/element/Text.hpp>
+#include <hyprtoolkit/element/Null.hpp>
+#include <hyprtoolkit/element/Image.hpp>
+#include <hyprtoolkit/element/Rectangle.hpp>
+
+#include <hyprutils/signal/Listener.hpp>
+
+#include "Backend.hpp"
+
+class CToolkitTimer : public ITimer {
+  public:
+    CToolkitTimer(ASP<Hyprtoolkit::CTimer> timer);
+
+    virtual void cancel();
+    virtual bool passed();
+
+  private:
+    ASP<Hyprtoolkit::CTimer> m_timer;
+};
+
+class CToolkitOutput : public IOutput {
+  public:
+    CToolkitOutput(SP<Hyprtoolkit::IOutput> output);
+
+    virtual const std::string&        port();
+    virtual const std::string&        desc();
+    virtual Hyprutils::Math::Vector2D pixelSize();
+    virtual uint32_t                  fps();
+
+    // port and desc are kept, they're still asked for once the output is gone
+    WP<Hyprtoolkit::IOutput>               m_output;
+    std::string                            m_port, m_desc;
+
+    Hyprutils::Signal::CHyprSignalListener m_removed;
+};
+
+class CToolkitImageLayer : public IImageLayer {
+  public:
+    CToolkitImageLayer(const SP<CDecodedImage>& image, Hyprtoolkit::eImageFitMode fitMode, float alpha);
+
+    virtual void                   setImage(const SP<CDecodedImage>& image, Hyprtoolkit::eImageFitMode fitMode);
+    virtual void                   setAlpha(float alpha);
+    virtual void                   setPosition(const Hyprutils::Math::Vector2D& pos);
+
+    SP<Hyprtoolkit::CImageElement> m_element;
+};
+
+class CToolkitWindow : public IWindow {
+  public:
+    CToolkitWindow(WP<Hyprtoolkit::IBackend> backend, SP<Hyprtoolkit::IOutput> output);
+
+    virtual void            setBackground(uint32_t color);
+    virtual SP<IImageLayer> addImage(const SP<CDecodedImage>& image, Hyprtoolkit::eImageFitMode fitMode, float alpha);
+    virtual void            removeImage(const SP<IImageLayer>& layer);
+    virtual void            setSplash(const std::string& text, float offset, float alpha);
+    virtual float           scale();
+
+  private:
+    WP<Hyprtoolkit::IBackend>          m_backend;
+    SP<Hyprtoolkit::IWindow>           m_window;
+    SP<Hyprtoolkit::CNullElement>      m_null;
+    SP<Hyprtoolkit::CRectangleElement> m_bg;
+    SP<Hyprtoolkit::CTextElement>      m_splash;
+
+    Hyprutils::Signal::CHyprSignalListener m_resized;
+};
+
+class CToolkitBackend : public IBackend {
+  public:
+    static SP<CToolkitBackend> create();
+
+    virtual SP<ITimer>               addTimer(Clock::duration timeout, std::function<void()>&& cb);
+    virtual void                     addIdle(std::function<void()>&& fn);
+    virtual void                     addFd(int fd, std::function<void()>&& cb);
+    virtual void                     removeFd(int fd);
+    virtual Clock::time_point        now();
+
+    virtual std::vector<SP<IOutput>> getOutputs();
+    virtual SP<IWindow>              createWindow(const SP<IOutput>& output);
+
+    virtual void                     enterLoop();
+
+  private:
+    CToolkitBackend(SP<Hyprtoolkit::IBackend> backend);
+
+    // the same toolkit output always maps to the same wrapper
+    SP<CToolkitOutput>                     wrap(const SP<Hyprtoolkit::IOutput>& output);
+
+    SP<Hyprtoolkit::IBackend>              m_backend;
+    std::vector<SP<CToolkitOutput>>        m_outputs;
+
+    Hyprutils::Signal::CHyprSignalListener m_outputAdded;
+};
@@ -1,85 +1,209 @@
 #include "ConfigManager.hpp"
 #include <algorithm>
+#include <bit>
+#include <charconv>
 #include <filesystem>
+#include <ranges>
 #include <glob.h>
-#include <random>
 #include <hyprlang.hpp>
 #include <hyprutils/path/Path.hpp>
 #include <hyprutils/string/String.hpp>
 #include <hyprutils/utils/ScopeGuard.hpp>
 #include <string>
 #include "../helpers/Logger.hpp"
+#include "../helpers/StartupProfiler.hpp"
+#include "../helpers/Stats.hpp"
+#include "../helpers/EventFd.hpp"
 #include "WallpaperMatcher.hpp"
+#include "ImageClassifier.hpp"
+#include "DirectoryScanner.hpp"
 
-#include <magic.h>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 using namespace std::string_literals;
 
-[[nodiscard]] static bool isImage(const std::filesystem::path& path) {
-    static constexpr std::array exts{".jpg", ".jpeg", ".png", ".bmp", ".webp", ".svg"};
+// Forward declaration for the source handler
+static Hyprlang::CParseResult handleSource(const char* COMMAND, const char* VALUE);
 
-    auto                        ext = path.extension().string();
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-    if (std::ranges::any_of(exts, [&ext](const auto& e) { return ext == e; }))
-        return true;
+static std::string            getMainConfigPath() {
+    static const auto paths = Hyprutils::Path::findConfig("hyprpaper");
 
-    magic_t magic = magic_open(MAGIC_MIME_TYPE);
-    if (magic == nullptr)
-        return false;
+    return paths.first.value_or("");
+}
 
-    Hyprutils::Utils::CScopeGuard guard{[&magic] { magic_close(magic); }};
+static Hyprlang::SConfigOptions configOptions() {
+    return Hyprlang::SConfigOptions{.throwAllErrors = true, .allowMissingConfig = true};
+}
 
-    if (magic_load(magic, nullptr) != 0)
-        return false;
+static void registerValues(Hyprlang::CConfig& config) {
+    config.addConfigValue("splash", Hyprlang::INT{1});
+    config.addConfigValue("splash_offset", Hyprlang::INT{20});
+    config.addConfigValue("splash_opacity", Hyprlang::FLOAT{0.8});
+    config.addConfigValue("ipc", Hyprlang::INT{1});
+    config.addConfigValue("cache_size", Hyprlang::INT{256});
+    config.addConfigValue("prefetch_size", Hyprlang::INT{128});
+    config.addConfigValue("disk_cache", Hyprlang::INT{0});
+    config.addConfigValue("disk_cache_size", Hyprlang::INT{1024});
+    config.addConfigValue("slideshow_sync", Hyprlang::INT{0});
+    config.addConfigValue("timer_slack", Hyprlang::INT{50});
+
+    config.addSpecialCategory("wallpaper", Hyprlang::SSpecialCategoryOptions{.key = "monitor"});
+    config.addSpecialConfigValue("wallpaper", "monitor", Hyprlang::STRING{""});
+    config.addSpecialConfigValue("wallpaper", "path", Hyprlang::STRING{""});
+    config.addSpecialConfigValue("wallpaper", "fit_mode", Hyprlang::STRING{"cover"});
+    config.addSpecialConfigValue("wallpaper", "timeout", Hyprlang::INT{0});
+    config.addSpecialConfigValue("wallpaper", "order", Hyprlang::STRING{"default"});
+    config.addSpecialConfigValue("wallpaper", "recursive", Hyprlang::INT{0});
+    config.addSpecialConfigValue("wallpaper", "prefetch", Hyprlang::INT{1});
+    config.addSpecialConfigValue("wallpaper", "prefetch_time", Hyprlang::INT{5});
+    config.addSpecialConfigValue("wallpaper", "transition", Hyprlang::STRING{"none"});
+    config.addSpecialConfigValue("wallpaper", "transition_duration", Hyprlang::INT{500});
+    config.addSpecialConfigValue("wallpaper", "color", Hyprlang::STRING{""});
+    config.addSpecialConfigValue("wallpaper", "gradient", Hyprlang::STRING{""});
+
+    config.registerHandler(&handleSource, "source", Hyprlang::SHandlerOptions{});
+
+    config.commence();
+}
+
+CConfigManager::CConfigManager(const std::string& configPath) : m_config(configPath.empty() ? getMainConfigPath().c_str() : configPath.c_str(), configOptions()) {
+    m_currentConfigPath = configPath.empty() ? getMainConfigPath() : configPath;
+}
+
+CConfigManager::~CConfigManager() {
+    if (m_resolveWorker.joinable())
+        m_resolveWorker.join();
+
+    if (m_resolveFd < 0)
+        return;
+
+    m_backend->removeFd(m_resolveFd);
+    close(m_resolveFd);
+}
+
+bool CConfigManager::init() {
+    registerValues(m_config);
 
-    const auto* result = magic_file(magic, path.string().c_str());
-    if (result == nullptr)
+    std::expected<std::vector<std::string>, std::string> result;
+
+    {
+        CScopedPhase phase("parse config", m_currentConfigPath);
+        result = parse(m_config);
+    }
+
+    if (!result) {
+        g_logger->log(LOG_ERR, "Config has errors:\n{}", result.error());
         return false;
+    }
+
+    m_sourcedFiles = std::move(*result);
 
-    return std::string(result).starts_with("image/");
+    g_matcher->applyConfig(getSettings());
+    return true;
 }
 
-// Forward declaration for the source handler
-static Hyprlang::CParseResult handleSource(const char* COMMAND, const char* VALUE);
+void CConfigManager::setBackend(SP<IBackend> backend) {
+    m_backend   = backend;
+    m_resolveFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
 
-static std::string            getMainConfigPath() {
-    static const auto paths = Hyprutils::Path::findConfig("hyprpaper");
+    // reloads just resolve on the main thread then
+    if (m_resolveFd < 0) {
+        g_logger->log(LOG_ERR, "CConfigManager: failed to create an eventfd: {}", strerror(errno));
+        return;
+    }
 
-    return paths.first.value_or("");
+    m_backend->addFd(m_resolveFd, [this] { onResolved(); });
 }
 
-CConfigManager::CConfigManager(const std::string& configPath) :
-    m_config(configPath.empty() ? getMainConfigPath().c_str() : configPath.c_str(), Hyprlang::SConfigOptions{.throwAllErrors = true, .allowMissingConfig = true}) {
-    m_currentConfigPath = configPath.empty() ? getMainConfigPath() : configPath;
+std::expected<std::vector<std::string>, std::string> CConfigManager::parse(Hyprlang::CConfig& config) {
+    m_parsing = &config;
+    m_parseSourced.clear();
+
+    const auto RESULT = config.parse();
+
+    m_parsing = &m_config;
+
+    if (RESULT.error)
+        return std::unexpected(RESULT.getError());
+
+    return std::move(m_parseSourced);
 }
 
-bool CConfigManager::init() {
-    m_config.addConfigValue("splash", Hyprlang::INT{1});
-    m_config.addConfigValue("splash_offset", Hyprlang::INT{20});
-    m_config.addConfigValue("splash_opacity", Hyprlang::FLOAT{0.8});
-    m_config.addConfigValue("ipc", Hyprlang::INT{1});
+std::expected<void, std::string> CConfigManager::reload() {
+    g_logger->log(LOG_DEBUG, "Reloading config");
 
-    m_config.addSpecialCategory("wallpaper", Hyprlang::SSpecialCategoryOptions{.key = "monitor"});
-    m_config.addSpecialConfigValue("wallpaper", "monitor", Hyprlang::STRING{""});
-    m_config.addSpecialConfigValue("wallpaper", "path", Hyprlang::STRING{""});
-    m_config.addSpecialConfigValue("wallpaper", "fit_mode", Hyprlang::STRING{"cover"});
-    m_config.addSpecialConfigValue("wallpaper", "timeout", Hyprlang::INT{0});
-    m_config.addSpecialConfigValue("wallpaper", "order", Hyprlang::STRING{"default"});
-    m_config.addSpecialConfigValue("wallpaper", "recursive", Hyprlang::INT{0});
+    // into a scratch config first, hyprlang keeps whatever it got to before an error
+    {
+        Hyprlang::CConfig scratch(m_currentConfigPath.c_str(), configOptions());
+        registerValues(scratch);
 
-    m_config.registerHandler(&handleSource, "source", Hyprlang::SHandlerOptions{});
+        if (const auto CHECKED = parse(scratch); !CHECKED) {
+            g_logger->log(LOG_ERR, "Config has errors, not applying it:\n{}", CHECKED.error());
+            return std::unexpected(CHECKED.error());
+        }
+    }
 
-    m_config.commence();
+    auto result = parse(m_config);
 
-    auto result = m_config.parse();
+    // only if a file changed since the scratch parse
+    if (!result) {
+        g_logger->log(LOG_ERR, "Config has errors, not applying it:\n{}", result.error());
+        return std::unexpected(result.error());
+    }
 
-    if (result.error) {
-        g_logger->log(LOG_ERR, "Config has errors:\n{}", result.getError());
-        return false;
+    m_sourcedFiles = std::move(*result);
+
+    if (m_resolveFd < 0) {
+        g_matcher->applyConfig(getSettings());
+        m_events.reloaded.emit();
+        return {};
     }
 
-    g_matcher->addStates(getSettings());
-    return true;
+    startResolve();
+    return {};
+}
+
+void CConfigManager::startResolve() {
+    // one at a time, the newest parse is resolved once this one is back
+    if (m_resolving) {
+        m_resolveAgain = true;
+        return;
+    }
+
+    m_resolving = true;
+
+    m_resolveWorker = std::thread([this, parsed = readSettings(), known = knownDirs()]() mutable {
+        resolve(parsed, known);
+        m_resolved = std::move(parsed);
+
+        if (!EventFd::signal(m_resolveFd))
+            g_logger->log(LOG_ERR, "CConfigManager: failed to wake the main thread: {}", strerror(errno));
+    });
+}
+
+void CConfigManager::onResolved() {
+    if (!EventFd::drain(m_resolveFd))
+        g_logger->log(LOG_ERR, "CConfigManager: failed to read the eventfd: {}", strerror(errno));
+
+    if (!m_resolving)
+        return;
+
+    m_resolveWorker.join();
+    m_resolving = false;
+
+    auto parsed = std::move(m_resolved);
+    m_resolved.clear();
+
+    if (m_resolveAgain) {
+        m_resolveAgain = false;
+        startResolve();
+        return;
+    }
+
+    g_matcher->applyConfig(finish(std::move(parsed)));
+    m_events.reloaded.emit();
 }
 
 Hyprlang::CConfig* CConfigManager::hyprlang() {
@@ -90,6 +214,25 @@ const std::string& CConfigManager::getCurrentConfigPath() const {
     return m_currentConfigPath;
 }
 
+std::vector<std::string> CConfigManager::configFiles() const {
+    std::vector<std::string> files;
+
+    if (!m_currentConfigPath.empty())
+        files.emplace_back(m_currentConfigPath);
+
+    files.insert(files.end(), m_sourcedFiles.begin(), m_sourcedFiles.end());
+    return files;
+}
+
+void CConfigManager::onFileSourced(const std::string& path) {
+    if (std::ranges::find(m_parseSourced, path) == m_parseSourced.end())
+        m_parseSourced.emplace_back(path);
+}
+
+Hyprlang::CConfig* CConfigManager::parsing() {
+    return m_parsing;
+}
+
 static std::expected<std::string, std::string> resolvePath(const std::string_view& sv) {
     std::error_code ec;
     const auto      CAN = std::filesystem::canonical(sv, ec);
@@ -121,15 +264,12 @@ static std::expected<std::string, std::string> getPath(const std::string_view& s
     return resolvePath(path);
 }
 
-static std::expected<std::vector<std::string>, std::string> getFullPath(const std::string& sv, const bool recursive) {
+// directory is set if sv resolved to one
+static std::expected<CPlaylist, std::string> getFullPath(const std::string& sv, const bool recursive, std::string& directory) {
     if (sv.empty())
         return std::unexpected("empty path");
 
-    static constexpr const size_t maxImagesCount{1024};
-
-    std::vector<std::string>      result;
-
-    const auto                    resolved = getPath(sv);
+    const auto resolved = getPath(sv);
     if (!resolved)
         return std::unexpected(resolved.error());
 
@@ -138,43 +278,39 @@ static std::expected<std::vector<std::string>, std::string> getFullPath(const st
         return std::unexpected(std::format("File '{}' does not exist", resolvedPath));
 
     if (std::filesystem::is_directory(resolvedPath)) {
-        auto processEntry = [&result](const auto& entry) {
-            if (entry.is_regular_file() && isImage(entry.path()))
-                result.push_back(entry.path());
-        };
-
-        if (recursive) {
-            for (const auto& entry :
-                 std::filesystem::recursive_directory_iterator(resolvedPath, std::filesystem::directory_options::skip_permission_denied)) {
-                processEntry(entry);
-                if (result.size() >= maxImagesCount)
-                    break;
-            }
-        } else {
-            for (const auto& entry : std::filesystem::directory_iterator(resolvedPath, std::filesystem::directory_options::skip_permission_denied)) {
-                processEntry(entry);
-                if (result.size() >= maxImagesCount)
-                    break;
-            }
-        }
+        directory = resolvedPath;
+
+        CDirectoryScanner scanner(resolvedPath, recursive);
+        auto              scanned = scanner.scan();
+        if (!scanned)
+            return std::unexpected(scanned.error());
+
+        return std::move(scanned->images);
     }
-    else if (isImage(resolvedPath))
-        result.push_back(resolvedPath);
-    else
+
+    if (!ImageClassifier::isImage(resolvedPath))
         return std::unexpected(std::format("File '{}' is neither an image nor a directory", resolvedPath));
 
+    CPlaylist result;
+    result.add(resolvedPath);
     return result;
 }
 
 std::vector<CConfigManager::SSetting> CConfigManager::getSettings() {
-    std::vector<CConfigManager::SSetting> result;
+    auto parsed = readSettings();
+    resolve(parsed, knownDirs());
+    return finish(std::move(parsed));
+}
+
+std::vector<CConfigManager::SParsed> CConfigManager::readSettings() {
+    std::vector<SParsed> result;
 
-    auto                                  keys = m_config.listKeysForSpecialCategory("wallpaper");
+    auto                 keys = m_config.listKeysForSpecialCategory("wallpaper");
     result.reserve(keys.size());
 
     for (auto& key : keys) {
-        std::string monitor, fitMode, path, order;
-        int         timeout, recursive;
+        std::string monitor, fitMode, path, order, transition, color, gradient;
+        int         timeout, recursive, prefetch, prefetchTime, transitionDuration;
 
         try {
             monitor = std::any_cast<Hyprlang::STRING>(m_config.getSpecialConfigValue("wallpaper", "monitor", key.c_str()));
@@ -183,41 +319,243 @@ std::vector<CConfigManager::SSetting> CConfigManager::getSettings() {
             timeout = std::any_cast<Hyprlang::INT>(m_config.getSpecialConfigValue("wallpaper", "timeout", key.c_str()));
             order     = std::any_cast<Hyprlang::STRING>(m_config.getSpecialConfigValue("wallpaper", "order", key.c_str()));
             recursive = std::any_cast<Hyprlang::INT>(m_config.getSpecialConfigValue("wallpaper", "recursive", key.c_str()));
+            prefetch     = std::any_cast<Hyprlang::INT>(m_config.getSpecialConfigValue("wallpaper", "prefetch", key.c_str()));
+            prefetchTime = std::any_cast<Hyprlang::INT>(m_config.getSpecialConfigValue("wallpaper", "prefetch_time", key.c_str()));
+            transition         = std::any_cast<Hyprlang::STRING>(m_config.getSpecialConfigValue("wallpaper", "transition", key.c_str()));
+            transitionDuration = std::any_cast<Hyprlang::INT>(m_config.getSpecialConfigValue("wallpaper", "transition_duration", key.c_str()));
+            color              = std::any_cast<Hyprlang::STRING>(m_config.getSpecialConfigValue("wallpaper", "color", key.c_str()));
+            gradient           = std::any_cast<Hyprlang::STRING>(m_config.getSpecialConfigValue("wallpaper", "gradient", key.c_str()));
         } catch (...) {
             g_logger->log(LOG_ERR, "Failed parsing wallpaper for key {}", key);
             continue;
         }
 
-        const auto RESOLVE_PATH = getFullPath(path, recursive != 0);
+        if (transition != "none" && transition != "crossfade" && transition != "slide" && transition != "wipe") {
+            g_logger->log(LOG_WARN, "Invalid transition value '{}', falling back to none", transition);
+            transition = "none";
+        }
+
+        // nothing to resolve or decode for these
+        if (!color.empty() || !gradient.empty()) {
+            if (!color.empty() && !gradient.empty()) {
+                g_logger->log(LOG_ERR, "Wallpaper for {} has both a color and a gradient", monitor);
+                continue;
+            }
+
+            auto fill = parseFill(color.empty() ? gradient : color, !gradient.empty());
+
+            if (!fill) {
+                g_logger->log(LOG_ERR, "Invalid {} '{}': {}", color.empty() ? "gradient" : "color", color.empty() ? gradient : color, fill.error());
+                continue;
+            }
 
-        if (!RESOLVE_PATH) {
-            g_logger->log(LOG_ERR, "Failed to resolve path {}: {}", path, RESOLVE_PATH.error());
+            if (!path.empty())
+                g_logger->log(LOG_WARN, "Wallpaper for {} has a {}, ignoring its path", monitor, color.empty() ? "gradient" : "color");
+
+            result.emplace_back(SParsed{.setting = SSetting{
+                                            .monitor            = std::move(monitor),
+                                            .fitMode            = std::move(fitMode),
+                                            .transition         = std::move(transition),
+                                            .transitionDuration = std::max(transitionDuration, 0),
+                                            .fill               = std::move(*fill),
+                                        }});
             continue;
         }
 
-        if (RESOLVE_PATH.value().empty()) {
-            g_logger->log(LOG_ERR, "Provided path(s) '{}' does not contain a valid image", path);
+        result.emplace_back(SParsed{
+            .setting =
+                SSetting{
+                    .monitor            = std::move(monitor),
+                    .fitMode            = std::move(fitMode),
+                    .recursive          = recursive != 0,
+                    .order              = std::move(order),
+                    .timeout            = timeout,
+                    .prefetch           = prefetch,
+                    .prefetchTime       = prefetchTime,
+                    .transition         = std::move(transition),
+                    .transitionDuration = std::max(transitionDuration, 0),
+                },
+            .path = std::move(path),
+        });
+    }
+
+    return result;
+}
+
+std::vector<CConfigManager::SKnownDir> CConfigManager::knownDirs() {
+    std::vector<SKnownDir> result;
+
+    for (const auto& s : g_matcher->configSettings()) {
+        if (!s.fill && !s.source.empty())
+            result.emplace_back(SKnownDir{.monitor = s.monitor, .source = s.source, .order = s.order, .recursive = s.recursive});
+    }
+
+    return result;
+}
+
+void CConfigManager::resolve(std::vector<SParsed>& parsed, const std::vector<SKnownDir>& known) {
+    const auto                    BEGIN = std::chrono::steady_clock::now();
+    Hyprutils::Utils::CScopeGuard x([BEGIN] {
+        statsAdd(g_stats->config.loads);
+        g_stats->config.loadUs.add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - BEGIN).count());
+    });
+
+    for (auto& p : parsed) {
+        if (p.setting.fill)
             continue;
-        }
 
-        auto resolvedPaths = RESOLVE_PATH.value();
+        auto& setting = p.setting;
 
-        if (resolvedPaths.size() > 1) {
-            if (order != "default" && order != "random" && order != "random-shuffle") {
-                g_logger->log(LOG_WARN, "Invalid order value '{}', falling back to default", order);
-                order = "default";
+        // a directory the current config used already is kept up to date by the watcher, it isn't scanned again
+        if (const auto DIR = getPath(p.path); DIR && std::filesystem::is_directory(*DIR)) {
+            p.known = std::ranges::any_of(known, [&setting, &DIR](const auto& k) {
+                return k.monitor == setting.monitor && k.source == *DIR && k.recursive == setting.recursive && k.order == setting.order;
+            });
+
+            if (p.known) {
+                setting.source = *DIR;
+                continue;
             }
+        }
+
+        std::expected<CPlaylist, std::string> resolved;
+
+        {
+            CScopedPhase phase("resolve path", p.path);
+            resolved = getFullPath(p.path, setting.recursive, setting.source);
+        }
+
+        if (!resolved) {
+            g_logger->log(LOG_ERR, "Failed to resolve path {}: {}", p.path, resolved.error());
+            p.valid = false;
+            continue;
+        }
+
+        if (resolved->empty()) {
+            g_logger->log(LOG_ERR, "Provided path(s) '{}' does not contain a valid image", p.path);
+            p.valid = false;
+            continue;
+        }
 
-            if (order == "random" || order == "random-shuffle") {
-                std::random_device rd;
-                std::mt19937       g(rd());
-                std::shuffle(resolvedPaths.begin(), resolvedPaths.end(), g);
+        if (resolved->size() > 1) {
+            if (setting.order != "default" && setting.order != "random" && setting.order != "random-shuffle") {
+                g_logger->log(LOG_WARN, "Invalid order value '{}', falling back to default", setting.order);
+                setting.order = "default";
             }
+
+            if (setting.order == "random" || setting.order == "random-shuffle")
+                resolved->shuffle();
+        }
+
+        p.images = std::move(*resolved);
+    }
+}
+
+std::vector<CConfigManager::SSetting> CConfigManager::finish(std::vector<SParsed>&& parsed) {
+    std::vector<SSetting> result;
+    result.reserve(parsed.size());
+
+    for (auto& p : parsed) {
+        if (!p.valid)
+            continue;
+
+        auto& setting = p.setting;
+
+        if (p.known) {
+            // applies are one at a time, so the entry it was matched against is still there
+            const auto& CURRENT = g_matcher->configSettings();
+            const auto  IT      = std::ranges::find_if(CURRENT, [&setting](const auto& s) {
+                return !s.fill && s.monitor == setting.monitor && s.source == setting.source && s.recursive == setting.recursive && s.order == setting.order;
+            });
+
+            if (IT == CURRENT.end())
+                continue;
+
+            setting.paths = IT->paths;
+        } else if (!setting.fill)
+            setting.paths = makeShared<CPlaylist>(std::move(p.images));
+
+        result.emplace_back(std::move(setting));
+    }
+
+    return result;
+}
+
+static std::expected<uint32_t, std::string> parseColor(std::string_view sv) {
+    std::string_view hex;
+    bool             alphaLast = false;
+
+    if (sv.starts_with("rgba(") && sv.ends_with(')')) {
+        hex       = sv.substr(5, sv.size() - 6);
+        alphaLast = true;
+    } else if (sv.starts_with("rgb(") && sv.ends_with(')'))
+        hex = sv.substr(4, sv.size() - 5);
+    else if (sv.starts_with("0x"))
+        hex = sv.substr(2);
+    else
+        return std::unexpected(std::format("'{}' is not a color, use rgb(RRGGBB), rgba(RRGGBBAA) or 0xAARRGGBB", sv));
+
+    const size_t DIGITS = sv.starts_with("rgb(") ? 6 : 8;
+    uint32_t     value  = 0;
+
+    const auto [PTR, EC] = std::from_chars(hex.data(), hex.data() + hex.size(), value, 16);
+    if (EC != std::errc{} || PTR != hex.data() + hex.size() || hex.size() != DIGITS)
+        return std::unexpected(std::format("'{}' should have {} hex digits", sv, DIGITS));
+
+    if (alphaLast)
+        return std::rotr(value, 8);
+
+    return DIGITS == 6 ? value | 0xFF000000 : value;
+}
+
+std::expected<CConfigManager::SFill, std::string> CConfigManager::parseFill(const std::string& str, bool gradient) {
+    SFill fill;
+
+    for (const auto& token : std::views::split(std::string_view{str}, ' ')) {
+        const std::string_view TOKEN{token.begin(), token.end()};
+
+        if (TOKEN.empty())
+            continue;
+
+        if (gradient && TOKEN.ends_with("deg")) {
+            const auto NUM       = TOKEN.substr(0, TOKEN.size() - 3);
+            const auto [PTR, EC] = std::from_chars(NUM.data(), NUM.data() + NUM.size(), fill.angle);
+            if (EC != std::errc{} || PTR != NUM.data() + NUM.size())
+                return std::unexpected(std::format("invalid angle '{}'", TOKEN));
+            continue;
         }
 
-        result.emplace_back(SSetting{.monitor = std::move(monitor), .fitMode = std::move(fitMode), .paths = std::move(resolvedPaths), .order = std::move(order), .timeout = timeout});
+        auto color = parseColor(TOKEN);
+        if (!color)
+            return std::unexpected(color.error());
+
+        fill.colors.emplace_back(*color);
+    }
+
+    if (fill.colors.empty())
+        return std::unexpected("no color given");
+
+    if (!gradient && fill.colors.size() > 1)
+        return std::unexpected("more than one color, use gradient for that");
+
+    if (gradient && fill.colors.size() < 2)
+        return std::unexpected("a gradient needs at least two colors");
+
+    fill.angle = ((fill.angle % 360) + 360) % 360;
+
+    return fill;
+}
+
+std::string CConfigManager::SFill::describe() const {
+    std::string result;
+
+    for (const auto C : colors) {
+        result += std::format("{}rgba({:08x})", result.empty() ? "" : " ", std::rotl(C, 8));
     }
 
+    if (colors.size() > 1)
+        result += std::format(" {}deg", angle);
+
     return result;
 }
 
@@ -259,7 +597,8 @@ static Hyprlang::CParseResult handleSource(const char* COMMAND, const char* VALU
 
         // Parse the single file
         g_logger->log(LOG_DEBUG, "source: parsing file '{}'", PATH);
-        auto parseResult = g_config->hyprlang()->parseFile(PATH.c_str());
+        g_config->onFileSourced(PATH);
+        auto parseResult = g_config->parsing()->parseFile(PATH.c_str());
         if (parseResult.error)
             result.setError(std::format("error parsing '{}': {}", PATH, parseResult.getError()).c_str());
         return result;
@@ -283,7 +622,8 @@ static Hyprlang::CParseResult handleSource(const char* COMMAND, const char* VALU
         }
 
         g_logger->log(LOG_DEBUG, "source: parsing file '{}'", matchedPath);
-        auto parseResult = g_config->hyprlang()->parseFile(matchedPath.c_str());
+        g_config->onFileSourced(matchedPath);
+        auto parseResult = g_config->parsing()->parseFile(matchedPath.c_str());
         if (parseResult.error)
             g_logger->log(LOG_ERR, "error parsing '{}': {}", matchedPath, parseResult.getError());
     }
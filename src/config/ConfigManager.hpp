@@ -2,38 +2,114 @@
 
 #include "../helpers/Memory.hpp"
 #include <hyprlang.hpp>
+#include <expected>
+#include <optional>
+#include <thread>
 #include <vector>
 
+#include <hyprutils/signal/Signal.hpp>
+
+#include "Playlist.hpp"
+#include "../backend/Backend.hpp"
+
 class CConfigManager {
   public:
     CConfigManager(const std::string& configPath);
-    ~CConfigManager() = default;
+    ~CConfigManager();
 
     CConfigManager(const CConfigManager&) = delete;
     CConfigManager(CConfigManager&)       = delete;
     CConfigManager(CConfigManager&&)      = delete;
 
+    // a flat color or a linear gradient, drawn without any image
+    struct SFill {
+        std::vector<uint32_t> colors;    // 0xAARRGGBB, a gradient if there's more than one
+        int                   angle = 0; // degrees, 0 runs left to right, 90 top to bottom
+
+        // how it's reported over IPC, in place of a path
+        std::string describe() const;
+
+        bool        operator==(const SFill&) const = default;
+    };
+
     struct SSetting {
-        std::string              monitor, fitMode;
-        std::vector<std::string> paths;
-        std::string              order   = "default";
-        int                      timeout = 0;
-        uint32_t                 id      = 0;
+        std::string          monitor, fitMode;
+        SP<const CPlaylist>  paths;  // immutable, shared by every target showing this setting
+        std::string          source; // set if paths came from a directory
+        bool                 recursive          = false;
+        std::string          order              = "default";
+        int                  timeout            = 0;
+        int                  prefetch           = 1;
+        int                  prefetchTime       = 5;
+        std::string          transition         = "none";
+        int                  transitionDuration = 500; // ms
+        std::optional<SFill> fill;                     // shown instead of an image, paths is null then
+        uint32_t             id = 0;
     };
 
     constexpr static const uint32_t SETTING_INVALID = 0;
 
-    bool                            init();
-    Hyprlang::CConfig*              hyprlang();
+    bool                             init();
+    // A config with errors is rejected as a whole and changes nothing. Once it parsed, paths
+    // are resolved on a worker if there's a backend, and applied when that's done.
+    std::expected<void, std::string> reload();
+    Hyprlang::CConfig*               hyprlang();
+    void                             setBackend(SP<IBackend> backend);
+
+    std::vector<SSetting>            getSettings();
+
+    // color: "rgb(RRGGBB)", "rgba(RRGGBBAA)" or "0xAARRGGBB". Gradients are several of them
+    // separated by spaces, optionally followed by an angle like "45deg".
+    static std::expected<SFill, std::string> parseFill(const std::string& str, bool gradient);
 
-    std::vector<SSetting>           getSettings();
+    const std::string&               getCurrentConfigPath() const;
 
-    const std::string&              getCurrentConfigPath() const;
+    // the main config and everything pulled in through source=
+    std::vector<std::string> configFiles() const;
+    void                     onFileSourced(const std::string& path);
+    // what source= parses into, the live config or a scratch one
+    Hyprlang::CConfig*       parsing();
+
+    struct {
+        Hyprutils::Signal::CSignalT<> reloaded;
+    } m_events;
 
   private:
-    Hyprlang::CConfig m_config;
+    // a wallpaper block as read from the config, resolve() fills in its images
+    struct SParsed {
+        SSetting    setting;
+        std::string path;
+        CPlaylist   images;
+        bool        known = false; // a directory the current config has, its playlist is kept
+        bool        valid = true;
+    };
+
+    // a directory of the current config, the watcher keeps its playlist up to date
+    struct SKnownDir {
+        std::string monitor, source, order;
+        bool        recursive = false;
+    };
+
+    std::expected<std::vector<std::string>, std::string> parse(Hyprlang::CConfig& config);
+    std::vector<SParsed>                                  readSettings();
+    std::vector<SKnownDir>                                knownDirs();
+    // touches the disk only, runs on the reload worker
+    static void                                           resolve(std::vector<SParsed>& parsed, const std::vector<SKnownDir>& known);
+    std::vector<SSetting>                                 finish(std::vector<SParsed>&& parsed);
+    void                                                  startResolve();
+    void                                                  onResolved();
+
+    Hyprlang::CConfig                                     m_config;
+    Hyprlang::CConfig*                                    m_parsing = &m_config;
+
+    std::string                                           m_currentConfigPath;
+    std::vector<std::string>                              m_sourcedFiles, m_parseSourced;
 
-    std::string       m_currentConfigPath;
+    SP<IBackend>                                          m_backend;
+    int                                                   m_resolveFd = -1;
+    std::thread                                           m_resolveWorker;
+    std::vector<SParsed>                                  m_resolved; // the worker's, read after joining it
+    bool                                                  m_resolving = false, m_resolveAgain = false;
 };
 
 inline UP<CConfigManager> g_config;
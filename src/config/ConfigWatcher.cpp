@@ -0,0 +1,104 @@
+#include "ConfigWatcher.hpp"
+#include "ConfigManager.hpp"
+#include "../helpers/Logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <hyprutils/memory/Casts.hpp>
+
+constexpr const uint32_t WATCH_MASK   = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ONLYDIR;
+constexpr const auto     RELOAD_DELAY = std::chrono::milliseconds(250);
+
+CConfigWatcher::CConfigWatcher(SP<IBackend> backend) : m_backend(backend) {
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (m_fd < 0) {
+        g_logger->log(LOG_ERR, "CConfigWatcher: inotify_init1 failed: {}, config won't be reloaded automatically", strerror(errno));
+        return;
+    }
+
+    m_backend->addFd(m_fd, [this] { onEvents(); });
+
+    // sourced files may have changed
+    m_reloaded = g_config->m_events.reloaded.listen([this] { sync(); });
+
+    sync();
+}
+
+CConfigWatcher::~CConfigWatcher() {
+    if (m_fd < 0)
+        return;
+
+    m_backend->removeFd(m_fd);
+    close(m_fd);
+}
+
+void CConfigWatcher::sync() {
+    for (const auto& [wd, _] : m_dirs) {
+        inotify_rm_watch(m_fd, wd);
+    }
+
+    m_dirs.clear();
+    m_files.clear();
+
+    for (const auto& f : g_config->configFiles()) {
+        m_files.emplace_back(f);
+
+        // symlinked configs: the link and its target may live in different places
+        std::error_code ec;
+        const auto      CANONICAL = std::filesystem::weakly_canonical(f, ec);
+        if (!ec && CANONICAL.string() != f)
+            m_files.emplace_back(CANONICAL.string());
+    }
+
+    for (const auto& f : m_files) {
+        const auto DIR = std::filesystem::path{f}.parent_path().string();
+
+        if (std::ranges::any_of(m_dirs, [&DIR](const auto& e) { return e.second == DIR; }))
+            continue;
+
+        const int WD = inotify_add_watch(m_fd, DIR.c_str(), WATCH_MASK);
+        if (WD < 0) {
+            g_logger->log(LOG_DEBUG, "CConfigWatcher: can't watch {}: {}", DIR, strerror(errno));
+            continue;
+        }
+
+        m_dirs[WD] = DIR;
+    }
+}
+
+void CConfigWatcher::onEvents() {
+    alignas(inotify_event) char buf[4096];
+    bool                        changed = false;
+
+    while (true) {
+        const auto LEN = read(m_fd, buf, sizeof(buf));
+        if (LEN <= 0)
+            break;
+
+        for (const char* p = buf; p < buf + LEN;) {
+            const auto* const EV = rc<const inotify_event*>(p);
+            p += sizeof(inotify_event) + EV->len;
+
+            const auto IT = m_dirs.find(EV->wd);
+            if (IT == m_dirs.end() || EV->len == 0)
+                continue;
+
+            const auto PATH = IT->second + "/" + EV->name;
+            if (std::ranges::find(m_files, PATH) != m_files.end())
+                changed = true;
+        }
+    }
+
+    // editors write in several steps, wait for them to settle
+    if (changed && !m_reloadTimer)
+        m_reloadTimer = m_backend->addTimer(RELOAD_DELAY, [this] {
+            m_reloadTimer.reset();
+            g_config->reload();
+        });
+}
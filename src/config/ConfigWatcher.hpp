@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <hyprutils/signal/Listener.hpp>
+
+#include "../backend/Backend.hpp"
+#include "../helpers/Memory.hpp"
+
+// Reloads the config when it, or anything it sources, changes on disk.
+// Watches the containing directories, as editors tend to replace files rather than write them.
+class CConfigWatcher {
+  public:
+    CConfigWatcher(SP<IBackend> backend);
+    ~CConfigWatcher();
+
+    CConfigWatcher(const CConfigWatcher&) = delete;
+    CConfigWatcher(CConfigWatcher&)       = delete;
+    CConfigWatcher(CConfigWatcher&&)      = delete;
+
+  private:
+    void                                   sync();
+    void                                   onEvents();
+
+    SP<IBackend>                           m_backend;
+    int                                    m_fd = -1;
+
+    std::vector<std::string>               m_files;
+    std::unordered_map<int, std::string>   m_dirs;
+
+    SP<ITimer>                             m_reloadTimer;
+
+    Hyprutils::Signal::CHyprSignalListener m_reloaded;
+};
+
+inline UP<CConfigWatcher> g_configWatcher;
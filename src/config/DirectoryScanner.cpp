@@ -0,0 +1,198 @@
+#include "DirectoryScanner.hpp"
+#include "ImageClassifier.hpp"
+#include "../helpers/Logger.hpp"
+#include "../helpers/Stats.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <hyprutils/utils/ScopeGuard.hpp>
+
+// files per classification job
+constexpr const size_t BATCH_SIZE = 64;
+
+static std::string     join(const std::string& dir, const char* name) {
+    return dir == "." ? std::string{name} : std::format("{}/{}", dir, name);
+}
+
+// d_type is not filled on every filesystem (e.g. some NFS setups), fall back to a stat there.
+// Symlinks to files are followed, symlinks to directories are not, like recursive_directory_iterator.
+static unsigned char entryType(int dirFd, const dirent* ent) {
+    if (ent->d_type != DT_UNKNOWN && ent->d_type != DT_LNK)
+        return ent->d_type;
+
+    struct stat st;
+    if (fstatat(dirFd, ent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+        return DT_UNKNOWN;
+
+    if (S_ISLNK(st.st_mode))
+        return fstatat(dirFd, ent->d_name, &st, 0) == 0 && S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+
+    return S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN);
+}
+
+CDirectoryScanner::CDirectoryScanner(std::string root, bool recursive) : m_root(std::move(root)), m_recursive(recursive) {
+    ;
+}
+
+std::expected<CDirectoryScanner::SResult, std::string> CDirectoryScanner::scan() {
+    const auto BEGIN = std::chrono::steady_clock::now();
+
+    m_rootFd = open(m_root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (m_rootFd < 0)
+        return std::unexpected(std::format("Can't open directory '{}': {}", m_root, strerror(errno)));
+
+    Hyprutils::Utils::CScopeGuard x([this] {
+        close(m_rootFd);
+        m_rootFd = -1;
+    });
+
+    m_queue.emplace_back(SWork{.dir = "."});
+
+    // mostly waiting on io, so more threads than the decode pool
+    const size_t             THREADS = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < THREADS; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    std::ranges::sort(m_found);
+
+    SResult result{
+        .dirs    = m_dirs,
+        .entries = m_entries,
+        .elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - BEGIN),
+    };
+
+    statsAdd(g_stats->config.scans);
+    g_stats->config.scanUs.add(result.elapsed.count());
+
+    const auto PREFIX = m_root.ends_with('/') ? m_root : m_root + "/";
+    for (const auto& rel : m_found) {
+        if (!result.images.add(PREFIX + rel)) {
+            g_logger->log(LOG_WARN, "'{}' has too many images, only using the first {}", m_root, result.images.size());
+            break;
+        }
+    }
+
+    result.images.shrinkToFit();
+    m_found.clear();
+    m_found.shrink_to_fit();
+
+    g_logger->log(LOG_DEBUG, "Scanned '{}' in {}ms: {} dir(s), {} entries, {} image(s) in {}kB", m_root, result.elapsed.count() / 1000.F, result.dirs, result.entries,
+                  result.images.size(), result.images.memoryUsage() / 1024);
+
+    return result;
+}
+
+void CDirectoryScanner::push(SWork&& work) {
+    {
+        std::lock_guard lg(m_mutex);
+        m_queue.emplace_back(std::move(work));
+    }
+    m_cv.notify_one();
+}
+
+void CDirectoryScanner::workerLoop() {
+    std::vector<std::string> found;
+
+    while (true) {
+        SWork work;
+
+        {
+            std::unique_lock lk(m_mutex);
+            m_cv.wait(lk, [this] { return !m_queue.empty() || m_active == 0; });
+
+            // nothing queued and nobody left who could queue more
+            if (m_queue.empty())
+                break;
+
+            work = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_active++;
+        }
+
+        if (work.names.empty())
+            readDir(work.dir);
+        else
+            classify(work, found);
+
+        {
+            std::lock_guard lg(m_mutex);
+            m_active--;
+        }
+        m_cv.notify_all();
+    }
+
+    std::lock_guard lg(m_mutex);
+    m_found.insert(m_found.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+}
+
+void CDirectoryScanner::readDir(const std::string& dir) {
+    const int FD = openat(m_rootFd, dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (FD < 0) {
+        // skip what we can't read, like skip_permission_denied did
+        g_logger->log(LOG_TRACE, "Skipping directory '{}/{}': {}", m_root, dir, strerror(errno));
+        return;
+    }
+
+    DIR* const DIRP = fdopendir(FD);
+    if (!DIRP) {
+        close(FD);
+        return;
+    }
+
+    Hyprutils::Utils::CScopeGuard x([DIRP] { closedir(DIRP); });
+
+    m_dirs++;
+
+    SWork batch{.dir = dir};
+
+    while (const auto* ent = readdir(DIRP)) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+            continue;
+
+        m_entries++;
+
+        const auto TYPE = entryType(FD, ent);
+
+        if (TYPE == DT_DIR) {
+            if (m_recursive)
+                push(SWork{.dir = join(dir, ent->d_name)});
+        } else if (TYPE == DT_REG) {
+            batch.names.emplace_back(ent->d_name);
+
+            if (batch.names.size() >= BATCH_SIZE) {
+                push(std::move(batch));
+                batch = SWork{.dir = dir};
+            }
+        }
+    }
+
+    if (!batch.names.empty())
+        push(std::move(batch));
+}
+
+void CDirectoryScanner::classify(const SWork& work, std::vector<std::string>& found) {
+    const int FD = openat(m_rootFd, work.dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (FD < 0)
+        return;
+
+    Hyprutils::Utils::CScopeGuard x([FD] { close(FD); });
+
+    for (const auto& name : work.names) {
+        if (ImageClassifier::isImageAt(FD, name.c_str()))
+            found.emplace_back(join(work.dir, name.c_str()));
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <expected>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Playlist.hpp"
+
+// Walks a wallpaper directory on a small worker pool. Both directory reads and file
+// classification fan out, and lookups are relative to open directory fds.
+// Results are sorted, so the order never depends on scheduling.
+class CDirectoryScanner {
+  public:
+    CDirectoryScanner(std::string root, bool recursive);
+    ~CDirectoryScanner() = default;
+
+    CDirectoryScanner(const CDirectoryScanner&) = delete;
+    CDirectoryScanner(CDirectoryScanner&)       = delete;
+    CDirectoryScanner(CDirectoryScanner&&)      = delete;
+
+    struct SResult {
+        CPlaylist                 images;
+        size_t                    dirs = 0, entries = 0;
+        std::chrono::microseconds elapsed{0};
+    };
+
+    std::expected<SResult, std::string> scan();
+
+  private:
+    // a directory to read if names is empty, otherwise a batch of files in it to classify
+    struct SWork {
+        std::string              dir;
+        std::vector<std::string> names;
+    };
+
+    void                     workerLoop();
+    void                     readDir(const std::string& dir);
+    void                     classify(const SWork& work, std::vector<std::string>& found);
+    void                     push(SWork&& work);
+
+    std::string              m_root;
+    bool                     m_recursive = false;
+    int                      m_rootFd    = -1;
+
+    std::mutex               m_mutex;
+    std::condition_variable  m_cv;
+    std::deque<SWork>        m_queue;
+    size_t                   m_active = 0;
+    std::vector<std::string> m_found;
+
+    std::atomic<size_t>      m_dirs = 0, m_entries = 0;
+};
@@ -0,0 +1,417 @@
+#include "DirectoryWatcher.hpp"
+#include "DirectoryScanner.hpp"
+#include "ImageClassifier.hpp"
+#include "WallpaperMatcher.hpp"
+#include "../image/ImageCache.hpp"
+#include "../helpers/Logger.hpp"
+#include "../helpers/EventFd.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <hyprutils/memory/Casts.hpp>
+
+constexpr const uint32_t WATCH_MASK  = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR;
+constexpr const auto     FLUSH_DELAY = std::chrono::milliseconds(500);
+
+static bool              isUnder(const std::string& path, const std::string& dir) {
+    return path.size() > dir.size() && path.starts_with(dir) && path[dir.size()] == '/';
+}
+
+static bool inScope(const std::string& path, const CConfigManager::SSetting& setting) {
+    if (setting.recursive)
+        return isUnder(path, setting.source);
+
+    return isUnder(path, setting.source) && path.find('/', setting.source.size() + 1) == std::string::npos;
+}
+
+CDirectoryWatcher::CDirectoryWatcher(SP<IBackend> backend) : m_backend(backend) {
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (m_fd < 0) {
+        g_logger->log(LOG_ERR, "CDirectoryWatcher: inotify_init1 failed: {}, directories won't be watched", strerror(errno));
+        return;
+    }
+
+    m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (m_eventFd < 0) {
+        g_logger->log(LOG_ERR, "CDirectoryWatcher: failed to create an eventfd: {}, directories won't be watched", strerror(errno));
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    m_worker = std::thread([this] { workerLoop(); });
+
+    m_backend->addFd(m_fd, [this] { onEvents(); });
+    m_backend->addFd(m_eventFd, [this] { onResults(); });
+
+    m_settingsChanged = g_matcher->m_events.settingsChanged.listen([this] { sync(); });
+
+    sync();
+}
+
+CDirectoryWatcher::~CDirectoryWatcher() {
+    if (m_fd < 0)
+        return;
+
+    {
+        std::lock_guard lg(m_mutex);
+        m_exit = true;
+    }
+
+    m_cv.notify_all();
+    m_worker.join();
+
+    m_backend->removeFd(m_eventFd);
+    m_backend->removeFd(m_fd);
+    close(m_eventFd);
+    close(m_fd);
+}
+
+void CDirectoryWatcher::sync() {
+    std::vector<SRoot> roots;
+
+    for (const auto& s : g_matcher->settings()) {
+        if (s.source.empty())
+            continue;
+
+        SRoot root{.dir = s.source, .recursive = s.recursive};
+        if (std::ranges::find(roots, root) == roots.end())
+            roots.emplace_back(std::move(root));
+    }
+
+    if (roots == m_roots)
+        return;
+
+    // roots rarely change, just start over
+    for (const auto& [wd, _] : m_watches) {
+        inotify_rm_watch(m_fd, wd);
+    }
+
+    m_watches.clear();
+    m_roots = std::move(roots);
+
+    for (const auto& r : m_roots) {
+        addWatches(r.dir, r.recursive);
+    }
+
+    g_logger->log(LOG_DEBUG, "CDirectoryWatcher: watching {} dir(s) for {} root(s)", m_watches.size(), m_roots.size());
+}
+
+void CDirectoryWatcher::addWatches(const std::string& dir, bool recursive) {
+    const auto WATCH = [this](const std::string& path) {
+        const int WD = inotify_add_watch(m_fd, path.c_str(), WATCH_MASK);
+
+        if (WD < 0) {
+            g_logger->log(LOG_WARN, "CDirectoryWatcher: can't watch {}: {}", path, strerror(errno));
+            return;
+        }
+
+        m_watches[WD] = path;
+    };
+
+    WATCH(dir);
+
+    if (!recursive)
+        return;
+
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(dir, std::filesystem::directory_options::skip_permission_denied, ec);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec)
+            break;
+
+        if (it->is_directory(ec) && !it->is_symlink(ec))
+            WATCH(it->path().string());
+    }
+}
+
+void CDirectoryWatcher::removeWatchesUnder(const std::string& dir) {
+    std::erase_if(m_watches, [this, &dir](const auto& e) {
+        if (e.second != dir && !isUnder(e.second, dir))
+            return false;
+
+        inotify_rm_watch(m_fd, e.first);
+        return true;
+    });
+}
+
+void CDirectoryWatcher::onEvents() {
+    alignas(inotify_event) char buf[16384];
+
+    while (true) {
+        const auto LEN = read(m_fd, buf, sizeof(buf));
+        if (LEN <= 0)
+            break;
+
+        for (const char* p = buf; p < buf + LEN;) {
+            const auto* const EV = rc<const inotify_event*>(p);
+            p += sizeof(inotify_event) + EV->len;
+
+            if (EV->mask & IN_Q_OVERFLOW) {
+                m_pending.rescan = true;
+                continue;
+            }
+
+            const auto IT = m_watches.find(EV->wd);
+            if (IT == m_watches.end())
+                continue;
+
+            if (EV->mask & IN_IGNORED) {
+                m_watches.erase(IT);
+                continue;
+            }
+
+            if (EV->len == 0)
+                continue;
+
+            auto path = IT->second + "/" + EV->name;
+
+            if (EV->mask & IN_ISDIR) {
+                if (EV->mask & (IN_CREATE | IN_MOVED_TO))
+                    m_pending.addedDirs.emplace_back(std::move(path));
+                else if (EV->mask & (IN_DELETE | IN_MOVED_FROM))
+                    m_pending.removedDirs.emplace_back(std::move(path));
+            } else if (EV->mask & (IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                // a new version of a file we showed gets a new cache key
+                if (g_imageCache)
+                    g_imageCache->forget(path);
+
+                m_pending.removed.erase(path);
+                m_pending.added.emplace(std::move(path));
+            } else if (EV->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                m_pending.added.erase(path);
+                m_pending.removed.emplace(std::move(path));
+            }
+        }
+    }
+
+    const bool HASWORK = m_pending.rescan || !m_pending.added.empty() || !m_pending.removed.empty() || !m_pending.addedDirs.empty() || !m_pending.removedDirs.empty();
+
+    if (HASWORK && !m_flushTimer)
+        m_flushTimer = m_backend->addTimer(FLUSH_DELAY, [this] { flush(); });
+}
+
+void CDirectoryWatcher::flush() {
+    m_flushTimer.reset();
+
+    SBatch batch{.pending = std::move(m_pending)};
+    m_pending = {};
+
+    if (batch.pending.rescan) {
+        g_logger->log(LOG_WARN, "CDirectoryWatcher: event queue overflowed, rescanning");
+
+        // watches may be stale too
+        m_roots.clear();
+        sync();
+
+        for (const auto& r : m_roots) {
+            batch.rescanned.emplace_back(r, CPlaylist{});
+        }
+    } else {
+        for (const auto& dir : batch.pending.removedDirs) {
+            removeWatchesUnder(dir);
+        }
+
+        // only followed under recursive roots
+        std::erase_if(batch.pending.addedDirs, [this](const auto& dir) {
+            return std::ranges::none_of(m_roots, [&dir](const auto& r) { return r.recursive && isUnder(dir, r.dir); });
+        });
+
+        for (const auto& dir : batch.pending.addedDirs) {
+            addWatches(dir, true);
+        }
+    }
+
+    {
+        std::lock_guard lg(m_mutex);
+        m_queue.emplace_back(std::move(batch));
+    }
+
+    m_cv.notify_one();
+}
+
+void CDirectoryWatcher::workerLoop() {
+    while (true) {
+        SBatch batch;
+
+        {
+            std::unique_lock lk(m_mutex);
+            m_cv.wait(lk, [this] { return m_exit || !m_queue.empty(); });
+
+            if (m_exit)
+                return;
+
+            batch = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        process(batch);
+
+        {
+            std::lock_guard lg(m_mutex);
+            m_results.emplace_back(std::move(batch));
+        }
+
+        if (!EventFd::signal(m_eventFd))
+            g_logger->log(LOG_ERR, "CDirectoryWatcher: failed to wake the main thread: {}", strerror(errno));
+    }
+}
+
+void CDirectoryWatcher::process(SBatch& batch) {
+    for (auto& [root, images] : batch.rescanned) {
+        CDirectoryScanner scanner(root.dir, root.recursive);
+        if (auto scanned = scanner.scan(); scanned)
+            images = std::move(scanned->images);
+    }
+
+    auto& pending = batch.pending;
+
+    std::erase_if(pending.added, [](const auto& path) { return !ImageClassifier::isImage(path); });
+
+    // whatever landed in there before the watch existed
+    for (const auto& dir : pending.addedDirs) {
+        CDirectoryScanner scanner(dir, true);
+        const auto        SCANNED = scanner.scan();
+        if (!SCANNED)
+            continue;
+
+        for (size_t i = 0; i < SCANNED->images.size(); ++i) {
+            pending.added.emplace(SCANNED->images.at(i));
+        }
+    }
+}
+
+void CDirectoryWatcher::onResults() {
+    if (!EventFd::drain(m_eventFd))
+        g_logger->log(LOG_ERR, "CDirectoryWatcher: failed to read the eventfd: {}", strerror(errno));
+
+    std::vector<SBatch> results;
+
+    {
+        std::lock_guard lg(m_mutex);
+        results = std::move(m_results);
+        m_results.clear();
+    }
+
+    for (const auto& batch : results) {
+        if (batch.pending.rescan) {
+            applyRescan(batch);
+            continue;
+        }
+
+        std::vector<std::pair<uint32_t, CPlaylist>> updates;
+
+        for (const auto& s : g_matcher->settings()) {
+            if (s.source.empty())
+                continue;
+
+            if (auto updated = applyChanges(s, batch.pending); updated)
+                updates.emplace_back(s.id, std::move(*updated));
+        }
+
+        for (auto& [id, playlist] : updates) {
+            g_matcher->updatePlaylist(id, makeShared<CPlaylist>(std::move(playlist)));
+        }
+    }
+}
+
+std::optional<CPlaylist> CDirectoryWatcher::applyChanges(const CConfigManager::SSetting& setting, const SPending& pending) {
+    std::vector<std::string> added;
+    for (const auto& path : pending.added) {
+        if (inScope(path, setting))
+            added.emplace_back(path);
+    }
+
+    const auto REMOVED = [&](const std::string& path) {
+        return pending.removed.contains(path) || std::ranges::any_of(pending.removedDirs, [&path](const auto& d) { return isUnder(path, d); });
+    };
+
+    const bool MAYREMOVE = std::ranges::any_of(pending.removed, [&setting](const auto& p) { return inScope(p, setting); }) ||
+        std::ranges::any_of(pending.removedDirs, [&setting](const auto& d) { return d == setting.source || isUnder(d, setting.source); });
+
+    if (added.empty() && !MAYREMOVE)
+        return std::nullopt;
+
+    // added is sorted, and so is the old list for the default order, so they can be merged
+    const bool        SORTED = setting.order == "default";
+    const auto&       OLD    = *setting.paths;
+    std::vector<bool> present(added.size(), false);
+    size_t            removed = 0, next = 0;
+    CPlaylist         result;
+
+    for (size_t i = 0; i < OLD.size(); ++i) {
+        const auto PATH = OLD.at(i);
+
+        if (SORTED) {
+            for (; next < added.size() && added[next] < PATH; ++next) {
+                result.add(added[next]);
+            }
+        }
+
+        if (const auto IT = std::ranges::lower_bound(added, PATH); IT != added.end() && *IT == PATH) {
+            present[IT - added.begin()] = true;
+            if (SORTED)
+                next = std::max<size_t>(next, IT - added.begin() + 1);
+        }
+
+        if (REMOVED(PATH)) {
+            removed++;
+            continue;
+        }
+
+        result.add(PATH);
+    }
+
+    for (size_t i = SORTED ? next : 0; i < added.size(); ++i) {
+        if (!present[i])
+            result.add(added[i]);
+    }
+
+    const size_t ADDED = result.size() + removed - OLD.size();
+
+    if (ADDED == 0 && removed == 0)
+        return std::nullopt;
+
+    if (result.empty()) {
+        g_logger->log(LOG_WARN, "CDirectoryWatcher: no images left in {}, keeping the old list", setting.source);
+        return std::nullopt;
+    }
+
+    g_logger->log(LOG_DEBUG, "CDirectoryWatcher: {}: {} added, {} removed, {} image(s) now", setting.source, ADDED, removed, result.size());
+
+    result.shrinkToFit();
+    return result;
+}
+
+void CDirectoryWatcher::applyRescan(const SBatch& batch) {
+    std::vector<std::pair<uint32_t, CPlaylist>> updates;
+
+    // settings may have changed while the worker was scanning, only roots still in use count
+    for (const auto& s : g_matcher->settings()) {
+        if (s.source.empty())
+            continue;
+
+        const SRoot ROOT{.dir = s.source, .recursive = s.recursive};
+        const auto  IT = std::ranges::find_if(batch.rescanned, [&ROOT](const auto& e) { return e.first == ROOT; });
+        if (IT == batch.rescanned.end() || IT->second.empty())
+            continue;
+
+        auto images = IT->second;
+        if (s.order != "default")
+            images.shuffle();
+
+        updates.emplace_back(s.id, std::move(images));
+    }
+
+    for (auto& [id, playlist] : updates) {
+        g_matcher->updatePlaylist(id, makeShared<CPlaylist>(std::move(playlist)));
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <hyprutils/signal/Listener.hpp>
+
+#include "ConfigManager.hpp"
+#include "../backend/Backend.hpp"
+
+// Watches the directories wallpaper settings were scanned from and applies
+// add / remove / rename deltas to their playlists. Events are batched for a short
+// while, so a bulk copy results in a handful of playlist updates.
+// Scans and file sniffing run on a worker, the playlists are updated back on the
+// main thread.
+class CDirectoryWatcher {
+  public:
+    CDirectoryWatcher(SP<IBackend> backend);
+    ~CDirectoryWatcher();
+
+    CDirectoryWatcher(const CDirectoryWatcher&) = delete;
+    CDirectoryWatcher(CDirectoryWatcher&)       = delete;
+    CDirectoryWatcher(CDirectoryWatcher&&)      = delete;
+
+  private:
+    struct SRoot {
+        std::string dir;
+        bool        recursive = false;
+
+        bool        operator==(const SRoot&) const = default;
+    };
+
+    struct SPending {
+        std::set<std::string>    added, removed;
+        std::vector<std::string> addedDirs, removedDirs;
+        bool                     rescan = false;
+    };
+
+    // A flushed batch. The worker drops everything but images from added and adds
+    // what's in the new directories, or for a rescan fills in every root's images.
+    struct SBatch {
+        SPending                                 pending;
+        std::vector<std::pair<SRoot, CPlaylist>> rescanned;
+    };
+
+    void                                   sync();
+    void                                   addWatches(const std::string& dir, bool recursive);
+    void                                   removeWatchesUnder(const std::string& dir);
+    void                                   onEvents();
+    void                                   flush();
+    void                                   workerLoop();
+    void                                   process(SBatch& batch);
+    void                                   onResults();
+    void                                   applyRescan(const SBatch& batch);
+    std::optional<CPlaylist>               applyChanges(const CConfigManager::SSetting& setting, const SPending& pending);
+
+    SP<IBackend>                           m_backend;
+    int                                    m_fd      = -1;
+    int                                    m_eventFd = -1;
+
+    std::vector<SRoot>                     m_roots;
+    std::unordered_map<int, std::string>   m_watches;
+
+    SPending                               m_pending;
+    SP<ITimer>                             m_flushTimer;
+
+    std::thread                            m_worker;
+    std::mutex                             m_mutex;
+    std::condition_variable                m_cv;
+    std::deque<SBatch>                     m_queue;
+    std::vector<SBatch>                    m_results;
+    bool                                   m_exit = false;
+
+    Hyprutils::Signal::CHyprSignalListener m_settingsChanged;
+};
+
+inline UP<CDirectoryWatcher> g_directoryWatcher;
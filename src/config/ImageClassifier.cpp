@@ -0,0 +1,159 @@
+#include "ImageClassifier.hpp"
+#include "../helpers/Memory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <magic.h>
+
+#include <hyprutils/memory/Casts.hpp>
+#include <hyprutils/utils/ScopeGuard.hpp>
+
+using namespace ImageClassifier;
+
+// Loading the magic database is expensive, do it once per thread and keep it around.
+class CMagic {
+  public:
+    CMagic() {
+        m_magic = magic_open(MAGIC_MIME_TYPE);
+
+        if (m_magic && magic_load(m_magic, nullptr) != 0) {
+            magic_close(m_magic);
+            m_magic = nullptr;
+        }
+    }
+
+    ~CMagic() {
+        if (m_magic)
+            magic_close(m_magic);
+    }
+
+    CMagic(const CMagic&) = delete;
+    CMagic(CMagic&)       = delete;
+    CMagic(CMagic&&)      = delete;
+
+    bool isImage(int fd) {
+        if (!m_magic)
+            return false;
+
+        // libmagic reads from the current offset
+        if (lseek(fd, 0, SEEK_SET) != 0)
+            return false;
+
+        const auto* result = magic_descriptor(m_magic, fd);
+        return result && std::string_view{result}.starts_with("image/");
+    }
+
+  private:
+    magic_t m_magic = nullptr;
+};
+
+static CMagic& threadMagic() {
+    static thread_local CMagic magic;
+    return magic;
+}
+
+static bool startsWith(std::span<const uint8_t> data, std::string_view prefix, size_t offset = 0) {
+    return data.size() >= offset + prefix.size() && std::memcmp(data.data() + offset, prefix.data(), prefix.size()) == 0;
+}
+
+eImageType ImageClassifier::sniffHeader(std::span<const uint8_t> header) {
+    if (startsWith(header, "\xFF\xD8\xFF"))
+        return IMAGE_TYPE_JPEG;
+    if (startsWith(header, "\x89PNG\r\n\x1A\n"))
+        return IMAGE_TYPE_PNG;
+    if (startsWith(header, "GIF87a") || startsWith(header, "GIF89a"))
+        return IMAGE_TYPE_GIF;
+    if (startsWith(header, "RIFF") && startsWith(header, "WEBP", 8))
+        return IMAGE_TYPE_WEBP;
+    if (startsWith(header, "\xFF\x0A") || startsWith(header, std::string_view{"\x00\x00\x00\x0CJXL \x0D\x0A\x87\x0A", 12}))
+        return IMAGE_TYPE_JXL;
+    if (startsWith(header, "II*\x00") || startsWith(header, std::string_view{"MM\x00*", 4}))
+        return IMAGE_TYPE_TIFF;
+    if (startsWith(header, "qoif"))
+        return IMAGE_TYPE_QOI;
+
+    if (startsWith(header, "ftyp", 4)) {
+        if (startsWith(header, "avif", 8) || startsWith(header, "avis", 8))
+            return IMAGE_TYPE_AVIF;
+        if (startsWith(header, "heic", 8) || startsWith(header, "heix", 8) || startsWith(header, "mif1", 8))
+            return IMAGE_TYPE_HEIF;
+    }
+
+    // BM is short enough to collide with text, check the reserved fields too
+    if (startsWith(header, "BM") && header.size() >= 10 && header[6] == 0 && header[7] == 0 && header[8] == 0 && header[9] == 0)
+        return IMAGE_TYPE_BMP;
+
+    // skip an utf-8 bom and leading whitespace for svg
+    size_t off = startsWith(header, "\xEF\xBB\xBF") ? 3 : 0;
+    while (off < header.size() && std::isspace(header[off])) {
+        off++;
+    }
+
+    if (startsWith(header, "<svg", off))
+        return IMAGE_TYPE_SVG;
+
+    return IMAGE_TYPE_UNKNOWN;
+}
+
+static eImageType sniffFd(int fd) {
+    std::array<uint8_t, HEADER_SIZE> header;
+    const auto                        LEN = read(fd, header.data(), header.size());
+
+    if (LEN <= 0)
+        return IMAGE_TYPE_UNKNOWN;
+
+    return sniffHeader({header.data(), sc<size_t>(LEN)});
+}
+
+static bool hasImageExtension(std::string_view name) {
+    static constexpr std::array exts{".jpg", ".jpeg", ".png", ".bmp", ".webp", ".svg"};
+
+    const auto                  DOT = name.rfind('.');
+    if (DOT == std::string_view::npos || DOT == 0 || name.size() - DOT > 5)
+        return false;
+
+    std::string ext{name.substr(DOT)};
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return std::ranges::any_of(exts, [&ext](const auto& e) { return ext == e; });
+}
+
+eImageType ImageClassifier::sniffFile(const std::filesystem::path& path) {
+    const int FD = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (FD < 0)
+        return IMAGE_TYPE_UNKNOWN;
+
+    const auto TYPE = sniffFd(FD);
+    close(FD);
+    return TYPE;
+}
+
+bool ImageClassifier::isImage(const std::filesystem::path& path) {
+    return isImageAt(AT_FDCWD, path.c_str());
+}
+
+bool ImageClassifier::isImageAt(int dirFd, const char* name) {
+    const std::string_view NAME{name};
+
+    if (hasImageExtension(NAME.substr(NAME.rfind('/') + 1)))
+        return true;
+
+    const int FD = openat(dirFd, name, O_RDONLY | O_CLOEXEC | O_NOCTTY);
+    if (FD < 0)
+        return false;
+
+    Hyprutils::Utils::CScopeGuard x([FD] { close(FD); });
+
+    if (sniffFd(FD) != IMAGE_TYPE_UNKNOWN)
+        return true;
+
+    // e.g. an xml-prefixed svg, or something exotic
+    return threadMagic().isImage(FD);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace ImageClassifier {
+    enum eImageType : uint8_t {
+        IMAGE_TYPE_UNKNOWN = 0,
+        IMAGE_TYPE_JPEG,
+        IMAGE_TYPE_PNG,
+        IMAGE_TYPE_GIF,
+        IMAGE_TYPE_BMP,
+        IMAGE_TYPE_WEBP,
+        IMAGE_TYPE_JXL,
+        IMAGE_TYPE_AVIF,
+        IMAGE_TYPE_HEIF,
+        IMAGE_TYPE_TIFF,
+        IMAGE_TYPE_QOI,
+        IMAGE_TYPE_SVG,
+    };
+
+    // how many bytes sniffHeader() wants to see
+    constexpr const size_t HEADER_SIZE = 32;
+
+    eImageType sniffHeader(std::span<const uint8_t> header);
+    eImageType sniffFile(const std::filesystem::path& path);
+
+    // Extension whitelist first, then the built-in signatures, and libmagic as a last resort.
+    bool isImage(const std::filesystem::path& path);
+    // Same, but relative to an open directory, for scanners. Thread-safe.
+    bool isImageAt(int dirFd, const char* name);
+};
@@ -0,0 +1,131 @@
+#include "Playlist.hpp"
+#include "../helpers/Memory.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <random>
+
+#include <hyprutils/memory/Casts.hpp>
+
+bool CPlaylist::add(std::string_view path) {
+    const auto SLASH = path.rfind('/');
+    const auto DIR   = SLASH == std::string_view::npos ? std::string_view{} : path.substr(0, SLASH + 1);
+    const auto NAME  = path.substr(DIR.size());
+
+    if (m_names.size() + NAME.size() + 1 > std::numeric_limits<uint32_t>::max() || m_entries.size() >= std::numeric_limits<uint32_t>::max())
+        return false;
+
+    uint32_t dirIdx = 0;
+    if (const auto IT = m_dirIndex.find(std::string{DIR}); IT != m_dirIndex.end())
+        dirIdx = IT->second;
+    else {
+        dirIdx = m_dirs.size();
+        m_dirs.emplace_back(DIR);
+        m_dirIndex.emplace(DIR, dirIdx);
+    }
+
+    m_entries.emplace_back(SEntry{.dir = dirIdx, .name = sc<uint32_t>(m_names.size())});
+    m_names.append(NAME);
+    m_names.push_back('\0');
+
+    return true;
+}
+
+void CPlaylist::shuffle() {
+    std::random_device rd;
+    std::mt19937       g(rd());
+    std::shuffle(m_entries.begin(), m_entries.end(), g);
+}
+
+void CPlaylist::shrinkToFit() {
+    m_entries.shrink_to_fit();
+    m_names.shrink_to_fit();
+}
+
+size_t CPlaylist::size() const {
+    return m_entries.size();
+}
+
+bool CPlaylist::empty() const {
+    return m_entries.empty();
+}
+
+std::string CPlaylist::at(size_t idx) const {
+    const auto& E = m_entries.at(idx);
+    return m_dirs[E.dir] + (m_names.data() + E.name);
+}
+
+std::optional<size_t> CPlaylist::find(std::string_view path) const {
+    const auto SLASH = path.rfind('/');
+    const auto DIR   = SLASH == std::string_view::npos ? std::string_view{} : path.substr(0, SLASH + 1);
+    const auto NAME  = path.substr(DIR.size());
+
+    const auto IT = m_dirIndex.find(std::string{DIR});
+    if (IT == m_dirIndex.end())
+        return std::nullopt;
+
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i].dir == IT->second && NAME == m_names.data() + m_entries[i].name)
+            return i;
+    }
+
+    return std::nullopt;
+}
+
+size_t CPlaylist::memoryUsage() const {
+    // directories are held twice, in the list and in the index
+    size_t dirs = 0;
+    for (const auto& d : m_dirs) {
+        dirs += d.capacity() * 2 + sizeof(d) * 2;
+    }
+
+    return m_entries.capacity() * sizeof(SEntry) + m_names.capacity() + dirs;
+}
+
+static uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+CIndexPermutation::CIndexPermutation(size_t n, uint64_t seed) : m_size(n) {
+    const auto BITS = n > 1 ? std::bit_width(n - 1) : 1;
+
+    m_halfBits = (BITS + 1) / 2;
+    m_halfMask = (1ULL << m_halfBits) - 1;
+
+    for (auto& k : m_keys) {
+        seed = mix(seed + 0x9e3779b97f4a7c15ULL);
+        k    = seed;
+    }
+}
+
+uint64_t CIndexPermutation::permute(uint64_t x) const {
+    uint64_t l = x >> m_halfBits, r = x & m_halfMask;
+
+    for (const auto& k : m_keys) {
+        const auto NEWR = l ^ (mix(r ^ k) & m_halfMask);
+        l               = r;
+        r               = NEWR;
+    }
+
+    return (l << m_halfBits) | r;
+}
+
+size_t CIndexPermutation::at(size_t idx) const {
+    if (m_size <= 1)
+        return 0;
+
+    // the domain is under 4n, so this takes a handful of rounds at most on average
+    uint64_t x = idx;
+    do {
+        x = permute(x);
+    } while (x >= m_size);
+
+    return x;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Compact list of wallpaper paths. Directories are interned and file names live
+// in one arena addressed by 32-bit offsets, so an entry costs 8 bytes plus its name.
+// Full paths are only materialized on access.
+class CPlaylist {
+  public:
+    CPlaylist() = default;
+
+    // false if the arena is full
+    bool                  add(std::string_view path);
+    void                  shuffle();
+    void                  shrinkToFit();
+
+    size_t                size() const;
+    bool                  empty() const;
+    std::string           at(size_t idx) const;
+    std::optional<size_t> find(std::string_view path) const;
+    size_t                memoryUsage() const;
+
+  private:
+    struct SEntry {
+        uint32_t dir  = 0;
+        uint32_t name = 0;
+    };
+
+    std::vector<SEntry>                       m_entries;
+    std::string                               m_names; // NUL-separated
+    std::vector<std::string>                  m_dirs;  // with the trailing slash
+    std::unordered_map<std::string, uint32_t> m_dirIndex;
+};
+
+// Random bijection over [0, n) in O(1) memory: a small Feistel network over the
+// next power of 4, cycle-walking anything that lands outside the range.
+class CIndexPermutation {
+  public:
+    CIndexPermutation(size_t n, uint64_t seed);
+
+    size_t at(size_t idx) const;
+
+  private:
+    uint64_t permute(uint64_t x) const;
+
+    size_t   m_size     = 0;
+    uint32_t m_halfBits = 0;
+    uint64_t m_halfMask = 0;
+    uint64_t m_keys[4]  = {};
+};
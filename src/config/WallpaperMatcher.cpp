@@ -2,104 +2,271 @@
 
 #include <algorithm>
 
-using namespace std::string_literals;
+#include "../helpers/Logger.hpp"
+
+#include <hyprutils/memory/Casts.hpp>
+
+using namespace std::string_view_literals;
 
 // Check if a monitor string represents a wildcard (matches all monitors)
 // Empty string or "*" are both treated as wildcards.
 // "*" is preferred since hyprlang's special category system doesn't properly
 // return entries with empty string keys from listKeysForSpecialCategory().
-static bool isWildcard(const std::string& monitor) {
+static bool isWildcard(const std::string_view& monitor) {
     return monitor.empty() || monitor == "*";
 }
 
+// same as ("desc:" + desc).starts_with(rule), without building the string
+static bool ruleMatches(const std::string_view& rule, const std::string_view& name, const std::string_view& desc) {
+    if (rule == name)
+        return true;
+
+    if (rule.size() <= 5)
+        return "desc:"sv.starts_with(rule);
+
+    return rule.starts_with("desc:") && desc.starts_with(rule.substr(5));
+}
+
 void CWallpaperMatcher::addState(CConfigManager::SSetting&& s) {
     s.id = ++m_maxId;
 
+    std::vector<std::string> rules = {s.monitor};
+
     std::erase_if(m_settings, [&s](const auto& e) { return e.monitor == s.monitor; });
     m_settings.emplace_back(std::move(s));
-    recalcStates();
+    rebuildIndex();
+    recalcStates(rules);
+    m_events.settingsChanged.emit();
 }
 
 void CWallpaperMatcher::addStates(std::vector<CConfigManager::SSetting>&& s) {
+    std::vector<std::string> rules;
+    rules.reserve(s.size());
+
     for (auto& ss : s) {
         ss.id = ++m_maxId;
+        rules.emplace_back(ss.monitor);
     }
 
     std::erase_if(m_settings, [&s](const auto& e) { return std::ranges::any_of(s, [&e](const auto& el) { return el.monitor == e.monitor; }); });
     m_settings.append_range(std::move(s));
-    recalcStates();
+    rebuildIndex();
+    recalcStates(rules);
+    m_events.settingsChanged.emit();
+}
+
+// whether a reloaded entry is the same as before. Directory contents are kept
+// up to date by the watcher, so only the directory itself is compared.
+static bool sameSetting(const CConfigManager::SSetting& a, const CConfigManager::SSetting& b) {
+    if (a.monitor != b.monitor || a.fitMode != b.fitMode || a.order != b.order || a.timeout != b.timeout || a.prefetch != b.prefetch || a.prefetchTime != b.prefetchTime ||
+        a.source != b.source || a.recursive != b.recursive || a.transition != b.transition || a.transitionDuration != b.transitionDuration || a.fill != b.fill)
+        return false;
+
+    if (!a.source.empty() || a.fill)
+        return true;
+
+    return a.paths->size() == b.paths->size() && a.paths->at(0) == b.paths->at(0);
+}
+
+void CWallpaperMatcher::applyConfig(std::vector<CConfigManager::SSetting>&& s) {
+    std::vector<std::string> rules;
+
+    // gone from the config: drop them, unless IPC has replaced them since
+    for (const auto& old : m_configSettings) {
+        if (std::ranges::any_of(s, [&old](const auto& e) { return e.monitor == old.monitor; }))
+            continue;
+
+        std::erase_if(m_settings, [&old](const auto& e) { return e.id == old.id; });
+        rules.emplace_back(old.monitor);
+    }
+
+    size_t changed = 0;
+
+    for (auto& ss : s) {
+        const auto OLD = std::ranges::find_if(m_configSettings, [&ss](const auto& e) { return e.monitor == ss.monitor; });
+
+        if (OLD != m_configSettings.end() && sameSetting(*OLD, ss)) {
+            ss.id = OLD->id;
+            continue;
+        }
+
+        ss.id = ++m_maxId;
+        changed++;
+
+        std::erase_if(m_settings, [&ss](const auto& e) { return e.monitor == ss.monitor; });
+        m_settings.emplace_back(ss);
+        rules.emplace_back(ss.monitor);
+    }
+
+    g_logger->log(LOG_DEBUG, "Config has {} wallpaper(s), {} changed", s.size(), changed);
+
+    m_configSettings = std::move(s);
+    rebuildIndex();
+    recalcStates(rules);
+    m_events.settingsChanged.emit();
+}
+
+void CWallpaperMatcher::updatePlaylist(uint32_t id, SP<const CPlaylist> playlist) {
+    const auto IT = m_byId.find(id);
+    if (IT == m_byId.end())
+        return;
+
+    // same setting, so targets keep it and just follow the new list
+    auto& setting = m_settings[IT->second];
+    setting.paths = playlist;
+
+    for (auto& cs : m_configSettings) {
+        if (cs.id == id)
+            cs.paths = playlist;
+    }
+
+    m_events.playlistChanged.emit(setting);
+}
+
+const std::vector<CConfigManager::SSetting>& CWallpaperMatcher::settings() const {
+    return m_settings;
+}
+
+const std::vector<CConfigManager::SSetting>& CWallpaperMatcher::configSettings() const {
+    return m_configSettings;
 }
 
 void CWallpaperMatcher::registerOutput(const std::string_view& s, const std::string_view& desc) {
     m_monitorNames.emplace_back(std::make_pair<>(s, desc));
-    recalcStates();
+
+    // nothing changed for anyone else, and a new monitor is always matched
+    recalcStates({});
 }
 
 void CWallpaperMatcher::unregisterOutput(const std::string_view& s) {
     std::erase_if(m_monitorNames, [&s](const auto& e) { return e.first == s; });
-    std::erase_if(m_monitorStates, [&s](const auto& e) { return e.name == s; });
-    recalcStates();
+
+    if (const auto IT = m_monitorStates.find(s); IT != m_monitorStates.end())
+        m_monitorStates.erase(IT);
 }
 
 bool CWallpaperMatcher::outputExists(const std::string_view& s) {
-    return std::ranges::any_of(m_monitorNames, [&s](const auto& e) { return e.first == s || "desc:" + e.second == s; });
+    return std::ranges::any_of(m_monitorNames, [&s](const auto& e) { return e.first == s || (s.starts_with("desc:") && s.substr(5) == e.second); });
 }
 
 std::optional<CWallpaperMatcher::rw<const CConfigManager::SSetting>> CWallpaperMatcher::getSetting(const std::string_view& monName, const std::string_view& monDesc) {
-    for (const auto& m : m_monitorStates) {
-        if (m.name != monName)
+    const auto STATE = m_monitorStates.find(monName);
+    if (STATE == m_monitorStates.end())
+        return std::nullopt;
+
+    const auto IT = m_byId.find(STATE->second.currentID);
+    if (IT == m_byId.end())
+        return std::nullopt;
+
+    return m_settings[IT->second];
+}
+
+void CWallpaperMatcher::rebuildIndex() {
+    m_byMonitor.clear();
+    m_byId.clear();
+    m_trie.assign(1, STrieNode{});
+    m_wildcard = NO_SETTING;
+
+    for (size_t i = 0; i < m_settings.size(); ++i) {
+        const auto& S = m_settings[i];
+
+        m_byId[S.id] = i;
+
+        if (isWildcard(S.monitor)) {
+            if (m_wildcard == NO_SETTING)
+                m_wildcard = i;
             continue;
+        }
+
+        // the first one wins, same as a scan in order would
+        m_byMonitor.try_emplace(S.monitor, i);
 
-        for (const auto& s : m_settings) {
-            if (s.id != m.currentID)
+        uint32_t node = 0;
+        for (const char c : S.monitor) {
+            const auto CHILD = std::ranges::find(m_trie[node].children, c, &std::pair<char, uint32_t>::first);
+
+            if (CHILD != m_trie[node].children.end()) {
+                node = CHILD->second;
                 continue;
-            return s;
+            }
+
+            m_trie[node].children.emplace_back(c, sc<uint32_t>(m_trie.size()));
+            node = sc<uint32_t>(m_trie.size());
+            m_trie.emplace_back();
         }
 
-        return std::nullopt;
+        if (m_trie[node].setting == NO_SETTING)
+            m_trie[node].setting = i;
     }
-
-    return std::nullopt;
 }
 
 std::optional<CWallpaperMatcher::rw<const CConfigManager::SSetting>> CWallpaperMatcher::matchSetting(const std::string_view& monName, const std::string_view& monDesc) {
-    // match explicit
-    for (const auto& s : m_settings) {
-        if (isWildcard(s.monitor))
-            continue;
-        if (s.monitor != monName && !("desc:"s + std::string{monDesc}).starts_with(s.monitor))
-            continue;
-        return s;
-    }
+    // explicit rules: the name exactly, or any rule that's a prefix of "desc:" + monDesc.
+    // The earliest setting wins, as the rules are in the order they were added.
+    size_t best = NO_SETTING;
+
+    if (const auto IT = m_byMonitor.find(monName); IT != m_byMonitor.end())
+        best = IT->second;
 
-    // match wildcard (empty string or "*")
-    for (const auto& s : m_settings) {
-        if (isWildcard(s.monitor))
-            return s;
+    uint32_t   node = 0;
+    const auto STEP = [&](char c) {
+        const auto CHILD = std::ranges::find(m_trie[node].children, c, &std::pair<char, uint32_t>::first);
+        if (CHILD == m_trie[node].children.end())
+            return false;
+
+        node = CHILD->second;
+        best = std::min(best, m_trie[node].setting);
+        return true;
+    };
+
+    if (std::ranges::all_of("desc:"sv, STEP)) {
+        for (const char c : monDesc) {
+            if (!STEP(c))
+                break;
+        }
     }
 
-    return std::nullopt;
+    // then the wildcard (empty string or "*")
+    if (best == NO_SETTING)
+        best = m_wildcard;
+
+    if (best == NO_SETTING)
+        return std::nullopt;
+
+    return m_settings[best];
 }
 
 CWallpaperMatcher::SMonitorState& CWallpaperMatcher::getState(const std::string_view& monName) {
-    for (auto& s : m_monitorStates) {
-        if (s.name == monName)
-            return s;
-    }
+    if (const auto IT = m_monitorStates.find(monName); IT != m_monitorStates.end())
+        return IT->second;
 
-    return m_monitorStates.emplace_back();
+    return m_monitorStates.emplace(std::string{monName}, SMonitorState{}).first->second;
 }
 
-void CWallpaperMatcher::recalcStates() {
+void CWallpaperMatcher::recalcStates(const std::vector<std::string>& changedRules) {
     std::vector<std::string_view> namesChanged;
 
     for (const auto& [name, desc] : m_monitorNames) {
-        const auto STATE       = matchSetting(name, desc);
         auto&      activeState = getState(name);
+        const auto CURRENT     = m_byId.find(activeState.currentID);
+
+        // only monitors a changed rule could apply to. Ones whose setting is gone are always rematched.
+        const bool AFFECTED = CURRENT == m_byId.end() || std::ranges::any_of(changedRules, [&](const auto& r) {
+                                  return isWildcard(r) ? isWildcard(m_settings[CURRENT->second].monitor) : ruleMatches(r, name, desc);
+                              });
+
+        if (!AFFECTED)
+            continue;
+
+        const auto STATE = matchSetting(name, desc);
+
+        if (!STATE) {
+            // had a wallpaper until now, its target has to go
+            if (activeState.currentID != CConfigManager::SETTING_INVALID)
+                namesChanged.emplace_back(name);
 
-        if (!STATE)
             activeState = {.name = name, .desc = desc, .currentID = CConfigManager::SETTING_INVALID};
-        else {
+        } else {
             activeState.name = name;
             activeState.desc = desc;
             if (activeState.currentID != STATE->get().id) {
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <limits>
+#include <map>
 #include <optional>
+#include <string>
 #include <tuple>
+#include <unordered_map>
 
 #include "ConfigManager.hpp"
 
@@ -21,6 +25,13 @@ class CWallpaperMatcher {
 
     void                                              addState(CConfigManager::SSetting&&);
     void                                              addStates(std::vector<CConfigManager::SSetting>&&);
+    // replaces what the previous config set. Entries which didn't change keep their id,
+    // so their targets aren't touched, and IPC overrides of them stay in place.
+    void                                              applyConfig(std::vector<CConfigManager::SSetting>&&);
+    void                                              updatePlaylist(uint32_t id, SP<const CPlaylist> playlist);
+    const std::vector<CConfigManager::SSetting>&      settings() const;
+    // what the current config set, before any IPC changes
+    const std::vector<CConfigManager::SSetting>&      configSettings() const;
 
     void                                              registerOutput(const std::string_view&, const std::string_view&);
     void                                              unregisterOutput(const std::string_view&);
@@ -29,26 +40,52 @@ class CWallpaperMatcher {
     std::optional<rw<const CConfigManager::SSetting>> getSetting(const std::string_view& monName, const std::string_view& monDesc);
 
     struct {
-        Hyprutils::Signal::CSignalT<const std::string_view&> monitorConfigChanged;
+        Hyprutils::Signal::CSignalT<const std::string_view&>         monitorConfigChanged;
+        Hyprutils::Signal::CSignalT<const CConfigManager::SSetting&> playlistChanged;
+        Hyprutils::Signal::CSignalT<>                                settingsChanged;
     } m_events;
 
   private:
-    void                                              recalcStates();
+    // rematches only the monitors the given rules (monitor strings) could apply to
+    void                                              recalcStates(const std::vector<std::string>& changedRules);
     std::optional<rw<const CConfigManager::SSetting>> matchSetting(const std::string_view& monName, const std::string_view& monDesc);
+    void                                              rebuildIndex();
 
     std::vector<CConfigManager::SSetting>             m_settings;
+    std::vector<CConfigManager::SSetting>             m_configSettings;
+
+    // indices into m_settings, rebuilt whenever it changes
+    constexpr static const size_t NO_SETTING = std::numeric_limits<size_t>::max();
+
+    struct SStringHash {
+        using is_transparent = void;
+
+        size_t operator()(const std::string_view& sv) const {
+            return std::hash<std::string_view>{}(sv);
+        }
+    };
+
+    struct STrieNode {
+        std::vector<std::pair<char, uint32_t>> children;
+        size_t                                 setting = NO_SETTING;
+    };
+
+    std::unordered_map<std::string, size_t, SStringHash, std::equal_to<>> m_byMonitor;
+    std::unordered_map<uint32_t, size_t>                                  m_byId;
+    std::vector<STrieNode>                                                m_trie     = {STrieNode{}}; // every explicit rule, node 0 is the root
+    size_t                                                                m_wildcard = NO_SETTING;
 
     struct SMonitorState {
         std::string name, desc;
         uint32_t    currentID = CConfigManager::SETTING_INVALID;
     };
 
-    std::vector<std::pair<std::string, std::string>> m_monitorNames;
-    std::vector<SMonitorState>                       m_monitorStates;
+    std::vector<std::pair<std::string, std::string>>  m_monitorNames;
+    std::map<std::string, SMonitorState, std::less<>> m_monitorStates;
 
-    uint32_t                                         m_maxId = 0;
+    uint32_t                                          m_maxId = 0;
 
-    SMonitorState&                                   getState(const std::string_view& monName);
+    SMonitorState&                                    getState(const std::string_view& monName);
 };
 
 inline UP<CWallpaperMatcher> g_matcher = makeUnique<CWallpaperMatcher>();
@@ -0,0 +1,31 @@
+#include "EventFd.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+
+bool EventFd::signal(int fd) {
+    const uint64_t ONE = 1;
+
+    while (write(fd, &ONE, sizeof(ONE)) < 0) {
+        if (errno == EINTR)
+            continue;
+
+        return errno == EAGAIN;
+    }
+
+    return true;
+}
+
+bool EventFd::drain(int fd) {
+    uint64_t count = 0;
+
+    while (read(fd, &count, sizeof(count)) < 0) {
+        if (errno == EINTR)
+            continue;
+
+        return errno == EAGAIN;
+    }
+
+    return true;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// Wakeups from worker threads to the event loop. Both retry on EINTR.
+namespace EventFd {
+    // Adds one to the counter. A full counter still wakes the reader, so that counts as sent.
+    bool signal(int fd);
+
+    // Resets the counter. Nothing pending (EAGAIN) isn't an error, the loop can wake spuriously.
+    bool drain(int fd);
+};
@@ -0,0 +1,162 @@
+#include "StartupProfiler.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <print>
+
+#include <unistd.h>
+
+#include <hyprutils/memory/Casts.hpp>
+
+static uint32_t threadId() {
+    static thread_local const uint32_t TID = sc<uint32_t>(gettid());
+    return TID;
+}
+
+static std::string jsonEscape(std::string_view sv) {
+    std::string result;
+    result.reserve(sv.size());
+
+    for (const char c : sv) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (sc<unsigned char>(c) < 0x20)
+                    result += std::format("\\u{:04x}", sc<unsigned char>(c));
+                else
+                    result += c;
+        }
+    }
+
+    return result;
+}
+
+static double toMs(CStartupProfiler::Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+static int64_t toUs(CStartupProfiler::Clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+CStartupProfiler::CStartupProfiler(std::string tracePath) : m_start(Clock::now()), m_tracePath(std::move(tracePath)) {
+    ;
+}
+
+void CStartupProfiler::add(std::string_view name, std::string_view detail, Clock::time_point begin, Clock::time_point end) {
+    if (m_done.load(std::memory_order_relaxed))
+        return;
+
+    std::lock_guard lg(m_mutex);
+    m_phases.emplace_back(SPhase{.name = std::string{name}, .detail = std::string{detail}, .begin = begin, .end = end, .tid = threadId()});
+}
+
+void CStartupProfiler::mark(std::string_view name, std::string_view detail) {
+    if (m_done.load(std::memory_order_relaxed))
+        return;
+
+    const auto      NOW = Clock::now();
+
+    std::lock_guard lg(m_mutex);
+    m_phases.emplace_back(SPhase{.name = std::string{name}, .detail = std::string{detail}, .begin = NOW, .end = NOW, .tid = threadId(), .instant = true});
+}
+
+void CStartupProfiler::expectOutputs(size_t count) {
+    m_expected = count;
+
+    if (m_ready >= m_expected)
+        finish();
+}
+
+void CStartupProfiler::outputReady(std::string_view monitor, bool ok) {
+    if (done())
+        return;
+
+    mark(ok ? "first image" : "first image failed", monitor);
+
+    if (++m_ready >= m_expected)
+        finish();
+}
+
+bool CStartupProfiler::done() const {
+    return m_done.load(std::memory_order_relaxed);
+}
+
+void CStartupProfiler::finish() {
+    if (m_done.exchange(true))
+        return;
+
+    // workers may be halfway through add()
+    std::lock_guard lg(m_mutex);
+
+    std::ranges::stable_sort(m_phases, {}, &SPhase::begin);
+
+    report();
+
+    if (!m_tracePath.empty())
+        writeTrace();
+}
+
+void CStartupProfiler::report() {
+    const auto MAINTID = threadId();
+
+    std::println("hyprpaper startup profile, {:.2f}ms to the first image on every output:", toMs(Clock::now() - m_start));
+    std::println("  {:>10} {:>10}  {:<20} {}", "start ms", "took ms", "phase", "detail");
+
+    for (const auto& p : m_phases) {
+        const auto TOOK = p.instant ? std::string{"-"} : std::format("{:.2f}", toMs(p.end - p.begin));
+        std::println("  {:>10.2f} {:>10} {}{:<20} {}", toMs(p.begin - m_start), TOOK, p.tid == MAINTID ? ' ' : '*', p.name, p.detail);
+    }
+
+    std::println("  (* off the main thread)");
+}
+
+void CStartupProfiler::writeTrace() {
+    std::ofstream ofs(m_tracePath, std::ios::trunc);
+
+    if (!ofs.good()) {
+        g_logger->log(LOG_ERR, "Can't write the startup trace to {}", m_tracePath);
+        return;
+    }
+
+    const auto PID = getpid();
+
+    ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    for (size_t i = 0; i < m_phases.size(); ++i) {
+        const auto& p = m_phases[i];
+
+        if (i > 0)
+            ofs << ",";
+
+        // instant events have no duration, complete ones do
+        const auto KIND = p.instant ? std::string{R"("ph":"i","s":"g")"} : std::format(R"("ph":"X","dur":{})", toUs(p.end - p.begin));
+
+        ofs << std::format(R"({{"name":"{}","cat":"startup",{},"ts":{},"pid":{},"tid":{},"args":{{"detail":"{}"}}}})", jsonEscape(p.name), KIND, toUs(p.begin - m_start), PID,
+                           p.tid, jsonEscape(p.detail));
+    }
+
+    ofs << "]}\n";
+
+    g_logger->log(LOG_DEBUG, "Wrote the startup trace to {}", m_tracePath);
+}
+
+CScopedPhase::CScopedPhase(std::string_view name, std::string_view detail) {
+    if (!g_profiler || g_profiler->done())
+        return;
+
+    m_name   = name;
+    m_detail = detail;
+    m_begin  = CStartupProfiler::Clock::now();
+    m_active = true;
+}
+
+CScopedPhase::~CScopedPhase() {
+    if (m_active)
+        g_profiler->add(m_name, m_detail, m_begin, CStartupProfiler::Clock::now());
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Memory.hpp"
+
+// Where the time from launch to the first wallpaper goes. Only exists with --profile-startup,
+// so everything checks g_profiler first. Phases may be recorded from any thread.
+// Once every initial output has its first image, a report is printed and, if asked for,
+// a Chrome trace (chrome://tracing, Perfetto) is written. Nothing is recorded after that.
+class CStartupProfiler {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    CStartupProfiler(std::string tracePath);
+
+    CStartupProfiler(const CStartupProfiler&) = delete;
+    CStartupProfiler(CStartupProfiler&)       = delete;
+    CStartupProfiler(CStartupProfiler&&)      = delete;
+
+    void add(std::string_view name, std::string_view detail, Clock::time_point begin, Clock::time_point end);
+    void mark(std::string_view name, std::string_view detail = "");
+
+    // how many outputs to wait for, known once the initial targets exist
+    void expectOutputs(size_t count);
+    // an output has its first image, or failed getting one
+    void outputReady(std::string_view monitor, bool ok = true);
+
+    bool done() const;
+
+  private:
+    struct SPhase {
+        std::string       name, detail;
+        Clock::time_point begin, end;
+        uint32_t          tid     = 0;
+        bool              instant = false;
+    };
+
+    void                finish();
+    void                report();
+    void                writeTrace();
+
+    Clock::time_point   m_start;
+    std::string         m_tracePath;
+
+    std::mutex          m_mutex;
+    std::vector<SPhase> m_phases;
+    size_t              m_ready    = 0;
+    size_t              m_expected = SIZE_MAX;
+    std::atomic<bool>   m_done     = false;
+};
+
+// times the enclosing scope as a phase, does nothing without --profile-startup
+class CScopedPhase {
+  public:
+    CScopedPhase(std::string_view name, std::string_view detail = "");
+    ~CScopedPhase();
+
+    CScopedPhase(const CScopedPhase&) = delete;
+    CScopedPhase(CScopedPhase&)       = delete;
+    CScopedPhase(CScopedPhase&&)      = delete;
+
+  private:
+    std::string_view                    m_name, m_detail;
+    CStartupProfiler::Clock::time_point m_begin;
+    bool                                m_active = false;
+};
+
+inline UP<CStartupProfiler> g_profiler;
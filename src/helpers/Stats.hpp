@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+#include "Memory.hpp"
+
+// Latency in log2 buckets of microseconds: bucket 0 holds 0us, bucket n [2^(n-1), 2^n)us,
+// and the last one everything from there on (~4s).
+struct SHistogram {
+    constexpr static size_t                    BUCKETS = 24;
+
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+
+    void                                       add(uint64_t us) {
+        buckets[std::min<size_t>(std::bit_width(us), BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // exclusive, UINT64_MAX for the last bucket
+    constexpr static uint64_t upperBound(size_t bucket) {
+        return bucket >= BUCKETS - 1 ? UINT64_MAX : uint64_t{1} << bucket;
+    }
+};
+
+// Always-on runtime counters. Everything here is a relaxed atomic,
+// as these are written from the decode workers too.
+struct SStats {
+    struct {
+        std::atomic<uint64_t> decodes        = 0;
+        std::atomic<uint64_t> decodeFailures = 0;
+        std::atomic<uint64_t> dctScaled      = 0; // JPEGs decoded at a reduced size
+        std::atomic<uint64_t> decodeTotalUs  = 0;
+        std::atomic<uint64_t> decodeMaxUs    = 0;
+        std::atomic<uint64_t> scales         = 0;
+        std::atomic<uint64_t> scaleTotalUs   = 0;
+        SHistogram            decodeUs, scaleUs;
+    } decode;
+
+    struct {
+        std::atomic<uint64_t> hits          = 0;
+        std::atomic<uint64_t> misses        = 0;
+        std::atomic<uint64_t> diskHits      = 0;
+        std::atomic<uint64_t> diskMisses    = 0;
+        std::atomic<uint64_t> residentBytes = 0;
+    } cache;
+
+    struct {
+        // building the image element, the upload itself is up to the toolkit
+        SHistogram presentUs;
+    } present;
+
+    struct {
+        std::atomic<uint64_t> ticks     = 0;
+        std::atomic<uint64_t> swaps     = 0;
+        std::atomic<uint64_t> lateSwaps = 0;
+        std::atomic<uint64_t> lateMaxUs = 0;
+        SHistogram            timerLateUs;
+    } slideshow;
+
+    struct {
+        std::atomic<uint64_t> applies      = 0;
+        std::atomic<uint64_t> transactions = 0;
+        std::atomic<uint64_t> reloads      = 0;
+        std::atomic<uint64_t> preloads     = 0;
+        std::atomic<uint64_t> queries      = 0;
+        std::atomic<uint64_t> failures     = 0;
+    } ipc;
+
+    struct {
+        std::atomic<uint64_t> loads = 0;
+        std::atomic<uint64_t> scans = 0;
+        SHistogram            loadUs, scanUs;
+    } config;
+};
+
+inline void statsMax(std::atomic<uint64_t>& v, uint64_t sample) {
+    auto cur = v.load(std::memory_order_relaxed);
+    while (cur < sample && !v.compare_exchange_weak(cur, sample, std::memory_order_relaxed)) {
+        ;
+    }
+}
+
+inline void statsAdd(std::atomic<uint64_t>& v, uint64_t amount = 1) {
+    v.fetch_add(amount, std::memory_order_relaxed);
+}
+
+inline UP<SStats> g_stats = makeUnique<SStats>();
@@ -0,0 +1,216 @@
+#include "DecodePool.hpp"
+#include "../helpers/Logger.hpp"
+#include "../helpers/Stats.hpp"
+#include "../helpers/StartupProfiler.hpp"
+#include "../helpers/EventFd.hpp"
+#include "Scaler.hpp"
+#include "DiskCache.hpp"
+#include "JpegDecoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+CDecodeJob::CDecodeJob(uint64_t id, std::string path, Callback&& cb) : path(std::move(path)), m_id(id), m_callback(std::move(cb)), m_queuedAt(std::chrono::steady_clock::now()) {
+    ;
+}
+
+CDecodeJob::~CDecodeJob() {
+    if (g_decodePool)
+        g_decodePool->cancel(m_id);
+}
+
+CDecodePool::CDecodePool(SP<IBackend> backend) : m_backend(backend) {
+    m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (m_eventFd < 0) {
+        g_logger->log(LOG_CRIT, "CDecodePool: failed to create an eventfd");
+        std::abort();
+    }
+
+    const auto THREADS = std::clamp(std::thread::hardware_concurrency() / 2, 1U, 4U);
+
+    for (size_t i = 0; i < THREADS; ++i) {
+        m_workers.emplace_back([this] { workerLoop(); });
+    }
+
+    m_backend->addFd(m_eventFd, [this] { dispatchResults(); });
+
+    g_logger->log(LOG_DEBUG, "CDecodePool: started {} decode worker(s)", THREADS);
+}
+
+CDecodePool::~CDecodePool() {
+    {
+        std::lock_guard lg(m_mutex);
+        m_exit = true;
+    }
+
+    m_cv.notify_all();
+
+    for (auto& t : m_workers) {
+        t.join();
+    }
+
+    m_backend->removeFd(m_eventFd);
+    close(m_eventFd);
+}
+
+SP<CDecodeJob> CDecodePool::decode(const SImageKey& key, CDecodeJob::Callback&& cb) {
+    const auto ID  = m_nextId++;
+    auto       job = SP<CDecodeJob>(new CDecodeJob(ID, key.path, std::move(cb)));
+
+    m_jobs[ID] = job.get();
+
+    {
+        std::lock_guard lg(m_mutex);
+        m_queue.emplace_back(SWork{.id = ID, .key = key});
+    }
+
+    m_cv.notify_one();
+
+    return job;
+}
+
+size_t CDecodePool::pending() const {
+    return m_jobs.size();
+}
+
+void CDecodePool::cancel(uint64_t id) {
+    m_jobs.erase(id);
+
+    std::lock_guard lg(m_mutex);
+    std::erase_if(m_queue, [id](const auto& e) { return e.id == id; });
+}
+
+void CDecodePool::workerLoop() {
+    while (true) {
+        SWork work;
+
+        {
+            std::unique_lock lk(m_mutex);
+            m_cv.wait(lk, [this] { return m_exit || !m_queue.empty(); });
+
+            if (m_exit)
+                return;
+
+            work = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        // the disk cache and the result need the file's version, the main thread doesn't stat anything
+        work.key = work.key.resolved();
+
+        bool fromDisk = false;
+        auto result   = process(work.key, fromDisk);
+
+        // SP refcounts aren't atomic, cairo's are. Keeps the pixels alive for the store below.
+        cairo_surface_t* toStore = g_diskCache && !fromDisk && result && *result ? cairo_surface_reference(result.value()->surface()->cairo()) : nullptr;
+
+        {
+            std::lock_guard lg(m_mutex);
+            m_results.emplace_back(SResult{
+                .id    = work.id,
+                .key   = work.key,
+                .image = result ? std::move(result.value()) : nullptr,
+                .error = result ? "" : std::move(result.error()),
+            });
+        }
+
+        if (!EventFd::signal(m_eventFd))
+            g_logger->log(LOG_ERR, "CDecodePool: failed to wake the main thread: {}", strerror(errno));
+
+        // only after the result is out, nobody waits for the disk
+        if (toStore) {
+            g_diskCache->store(work.key, toStore);
+            cairo_surface_destroy(toStore);
+        }
+    }
+}
+
+// big JPEGs come out of the decoder at a fraction of their size already, everything else in full
+static std::expected<SP<CDecodedImage>, std::string> decodeFile(const SImageKey& key) {
+    auto scaled = JpegDecoder::decodeScaled(key.path, {sc<double>(key.width), sc<double>(key.height)}, key.fitMode);
+
+    if (scaled && *scaled) {
+        statsAdd(g_stats->decode.dctScaled);
+        return scaled;
+    }
+
+    if (!scaled)
+        g_logger->log(LOG_DEBUG, "CDecodePool: scaled decode of {} failed, decoding it in full: {}", key.path, scaled.error());
+
+    return CDecodedImage::fromFile(key.path);
+}
+
+std::expected<SP<CDecodedImage>, std::string> CDecodePool::process(const SImageKey& key, bool& fromDisk) {
+    CScopedPhase phase("decode", key.path);
+
+    if (g_diskCache) {
+        if (auto cached = g_diskCache->load(key)) {
+            statsAdd(g_stats->cache.diskHits);
+            fromDisk = true;
+            return cached;
+        }
+
+        statsAdd(g_stats->cache.diskMisses);
+    }
+
+    const auto BEGIN  = std::chrono::steady_clock::now();
+    auto       result = decodeFile(key);
+    const auto TOOKUS = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - BEGIN).count();
+
+    statsAdd(g_stats->decode.decodes);
+    statsAdd(g_stats->decode.decodeTotalUs, TOOKUS);
+    statsMax(g_stats->decode.decodeMaxUs, TOOKUS);
+    g_stats->decode.decodeUs.add(TOOKUS);
+
+    if (!result) {
+        statsAdd(g_stats->decode.decodeFailures);
+        return result;
+    }
+
+    // don't keep more pixels around than the output can show
+    const auto SCALEBEGIN = std::chrono::steady_clock::now();
+    result                = Scaler::scale(result.value(), {sc<double>(key.width), sc<double>(key.height)}, key.fitMode);
+    const auto SCALEUS    = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - SCALEBEGIN).count();
+
+    statsAdd(g_stats->decode.scales);
+    statsAdd(g_stats->decode.scaleTotalUs, SCALEUS);
+    g_stats->decode.scaleUs.add(SCALEUS);
+
+    return result;
+}
+
+void CDecodePool::dispatchResults() {
+    if (!EventFd::drain(m_eventFd))
+        g_logger->log(LOG_ERR, "CDecodePool: failed to read the eventfd: {}", strerror(errno));
+
+    std::vector<SResult> results;
+
+    {
+        std::lock_guard lg(m_mutex);
+        results = std::move(m_results);
+        m_results.clear();
+    }
+
+    for (auto& r : results) {
+        const auto IT = m_jobs.find(r.id);
+
+        if (IT == m_jobs.end())
+            continue; // cancelled in the meantime
+
+        auto* const job = IT->second;
+        m_jobs.erase(IT);
+
+        g_logger->log(LOG_TRACE, "CDecodePool: {} ready after {}ms", job->path,
+                      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - job->m_queuedAt).count());
+
+        if (!r.image)
+            g_logger->log(LOG_ERR, "Failed to decode {}: {}", job->path, r.error);
+
+        // move the callback out, the job may be destroyed from within it
+        auto cb = std::move(job->m_callback);
+        cb(std::move(r.image), r.key);
+    }
+}
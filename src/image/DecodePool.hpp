@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "DecodedImage.hpp"
+#include "ImageKey.hpp"
+#include "../backend/Backend.hpp"
+
+class CDecodePool;
+
+// A pending decode. The callback fires on the main thread once the image is ready
+// (or with nullptr on failure), along with the key resolved by the worker.
+// Dropping the job cancels it.
+// Images are downscaled to fit the requested output size before being handed back.
+class CDecodeJob {
+  public:
+    ~CDecodeJob();
+
+    CDecodeJob(const CDecodeJob&) = delete;
+    CDecodeJob(CDecodeJob&)       = delete;
+    CDecodeJob(CDecodeJob&&)      = delete;
+
+    using Callback = std::function<void(SP<CDecodedImage>, const SImageKey&)>;
+
+    const std::string path;
+
+  private:
+    CDecodeJob(uint64_t id, std::string path, Callback&& cb);
+
+    uint64_t                              m_id = 0;
+    Callback                              m_callback;
+    std::chrono::steady_clock::time_point m_queuedAt;
+
+    friend class CDecodePool;
+};
+
+class CDecodePool {
+  public:
+    CDecodePool(SP<IBackend> backend);
+    ~CDecodePool();
+
+    CDecodePool(const CDecodePool&) = delete;
+    CDecodePool(CDecodePool&)       = delete;
+    CDecodePool(CDecodePool&&)      = delete;
+
+    SP<CDecodeJob> decode(const SImageKey& key, CDecodeJob::Callback&& cb);
+    // jobs whose callback hasn't run yet
+    size_t         pending() const;
+
+  private:
+    struct SWork {
+        uint64_t  id = 0;
+        SImageKey key;
+    };
+
+    struct SResult {
+        uint64_t          id = 0;
+        SImageKey         key;
+        SP<CDecodedImage> image;
+        std::string       error;
+    };
+
+    void                                          workerLoop();
+    std::expected<SP<CDecodedImage>, std::string> process(const SImageKey& key, bool& fromDisk);
+    void                                          dispatchResults();
+    void                                          cancel(uint64_t id);
+
+    SP<IBackend>                                  m_backend;
+    int                                           m_eventFd = -1;
+
+    std::vector<std::thread>                      m_workers;
+    std::mutex                                    m_mutex;
+    std::condition_variable                       m_cv;
+    std::deque<SWork>                             m_queue;
+    std::vector<SResult>                          m_results;
+    bool                                          m_exit = false;
+
+    // main thread only
+    std::unordered_map<uint64_t, CDecodeJob*> m_jobs;
+    uint64_t                                  m_nextId = 1;
+
+    friend class CDecodeJob;
+};
+
+inline UP<CDecodePool> g_decodePool;
@@ -0,0 +1,82 @@
+#include "DecodedImage.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include <hyprgraphics/image/Image.hpp>
+#include <hyprutils/memory/Casts.hpp>
+
+// a gradient has no detail to lose, the image element stretches it over the output
+constexpr const double GRADIENT_SIZE = 256;
+
+CDecodedImage::CDecodedImage(std::string path, SP<Hyprgraphics::CCairoSurface> surface) : m_path(std::move(path)), m_surface(std::move(surface)) {
+    ;
+}
+
+std::expected<SP<CDecodedImage>, std::string> CDecodedImage::fromFile(const std::string& path) {
+    Hyprgraphics::CImage image(path);
+
+    if (!image.success())
+        return std::unexpected(image.getError());
+
+    auto surface = image.cairoSurface();
+    if (!surface || surface->status() != CAIRO_STATUS_SUCCESS)
+        return std::unexpected("decoder returned an invalid surface");
+
+    return makeShared<CDecodedImage>(path, std::move(surface));
+}
+
+std::expected<SP<CDecodedImage>, std::string> CDecodedImage::gradient(std::string name, const std::vector<uint32_t>& colors, int angle, const Hyprutils::Math::Vector2D& output) {
+    const double SCALE = GRADIENT_SIZE / std::max({output.x, output.y, 1.0});
+    const double W     = std::max(std::round(output.x * SCALE), 1.0);
+    const double H     = std::max(std::round(output.y * SCALE), 1.0);
+
+    auto* const  surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, sc<int>(W), sc<int>(H));
+
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        return std::unexpected("failed to allocate the surface");
+    }
+
+    // through the center, just long enough for the corners to get the first and last color
+    const double RAD  = angle * std::numbers::pi / 180.0;
+    const double DX   = std::cos(RAD);
+    const double DY   = std::sin(RAD);
+    const double HALF = (std::abs(W * DX) + std::abs(H * DY)) / 2.0;
+
+    auto* const  pattern = cairo_pattern_create_linear((W / 2.0) - (DX * HALF), (H / 2.0) - (DY * HALF), (W / 2.0) + (DX * HALF), (H / 2.0) + (DY * HALF));
+
+    for (size_t i = 0; i < colors.size(); ++i) {
+        const auto C = colors[i];
+        cairo_pattern_add_color_stop_rgba(pattern, sc<double>(i) / sc<double>(std::max<size_t>(colors.size() - 1, 1)), ((C >> 16) & 0xFF) / 255.0, ((C >> 8) & 0xFF) / 255.0,
+                                          (C & 0xFF) / 255.0, ((C >> 24) & 0xFF) / 255.0);
+    }
+
+    auto* const cr = cairo_create(surface);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source(cr, pattern);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+    cairo_pattern_destroy(pattern);
+
+    cairo_surface_flush(surface);
+
+    return makeShared<CDecodedImage>(std::move(name), makeShared<Hyprgraphics::CCairoSurface>(surface));
+}
+
+const std::string& CDecodedImage::path() const {
+    return m_path;
+}
+
+Hyprutils::Math::Vector2D CDecodedImage::size() const {
+    return m_surface->size();
+}
+
+size_t CDecodedImage::bytes() const {
+    return sc<size_t>(m_surface->stride()) * sc<size_t>(m_surface->size().y);
+}
+
+SP<Hyprgraphics::CCairoSurface> CDecodedImage::surface() const {
+    return m_surface;
+}
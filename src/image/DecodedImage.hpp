@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <expected>
+#include <vector>
+
+#include <hyprgraphics/cairo/CairoSurface.hpp>
+#include <hyprutils/math/Vector2D.hpp>
+
+#include "../helpers/Memory.hpp"
+
+// A fully decoded image, ready to be handed to an image element.
+class CDecodedImage {
+  public:
+    CDecodedImage(std::string path, SP<Hyprgraphics::CCairoSurface> surface);
+    ~CDecodedImage() = default;
+
+    CDecodedImage(const CDecodedImage&) = delete;
+    CDecodedImage(CDecodedImage&)       = delete;
+    CDecodedImage(CDecodedImage&&)      = delete;
+
+    static std::expected<SP<CDecodedImage>, std::string> fromFile(const std::string& path);
+    // a linear gradient with the output's aspect ratio, but only a few hundred pixels big
+    static std::expected<SP<CDecodedImage>, std::string> gradient(std::string name, const std::vector<uint32_t>& colors, int angle, const Hyprutils::Math::Vector2D& output);
+
+    const std::string&                                   path() const;
+    Hyprutils::Math::Vector2D                            size() const;
+    size_t                                               bytes() const;
+    SP<Hyprgraphics::CCairoSurface>                      surface() const;
+
+  private:
+    std::string                     m_path;
+    SP<Hyprgraphics::CCairoSurface> m_surface;
+};
@@ -0,0 +1,289 @@
+#include "DiskCache.hpp"
+#include "../helpers/Logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <hyprutils/memory/Casts.hpp>
+#include <hyprutils/utils/ScopeGuard.hpp>
+
+constexpr const uint32_t ENTRY_MAGIC   = 0x31435048; // "HPC1"
+constexpr const uint32_t ENTRY_VERSION = 1;
+constexpr const size_t   DATA_ALIGN    = 4096;
+
+struct SEntryHeader {
+    uint32_t magic   = ENTRY_MAGIC;
+    uint32_t version = ENTRY_VERSION;
+
+    // key
+    int64_t  mtime    = 0;
+    uint64_t fileSize = 0;
+    uint32_t outputW = 0, outputH = 0;
+    uint32_t fitMode = 0;
+    uint32_t pathLen = 0;
+
+    // pixels
+    uint32_t width = 0, height = 0;
+    uint32_t stride = 0, format = 0;
+    uint64_t dataOffset = 0;
+};
+
+struct SMapping {
+    void*  addr = nullptr;
+    size_t len  = 0;
+};
+
+static cairo_user_data_key_t MAPPING_KEY;
+
+static void                  unmapEntry(void* data) {
+    const auto MAPPING = sc<SMapping*>(data);
+    munmap(MAPPING->addr, MAPPING->len);
+    delete MAPPING;
+}
+
+// stable across runs, unlike std::hash
+static uint64_t fnv1a(uint64_t h, const void* data, size_t len) {
+    const auto BYTES = sc<const uint8_t*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        h ^= BYTES[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static bool writeAll(int fd, const void* data, size_t len) {
+    const auto* ptr = sc<const uint8_t*>(data);
+    while (len > 0) {
+        const auto WRITTEN = write(fd, ptr, len);
+        if (WRITTEN < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        ptr += WRITTEN;
+        len -= WRITTEN;
+    }
+    return true;
+}
+
+CDiskCache::CDiskCache(std::string dir, size_t budget) : m_dir(std::move(dir)), m_budget(budget) {
+    std::error_code ec;
+    std::filesystem::create_directories(m_dir, ec);
+
+    if (ec) {
+        g_logger->log(LOG_ERR, "CDiskCache: failed to create {}: {}", m_dir, ec.message());
+        return;
+    }
+
+    scan();
+}
+
+// drops leftovers of writes that never finished and sums up the rest
+void CDiskCache::scan() {
+    std::lock_guard lg(m_evictMutex);
+    std::error_code ec;
+
+    m_used = 0;
+
+    for (const auto& entry : std::filesystem::directory_iterator(m_dir, ec)) {
+        if (!entry.is_regular_file(ec))
+            continue;
+
+        if (entry.path().extension() == ".tmp") {
+            g_logger->log(LOG_DEBUG, "CDiskCache: removing leftover {}", entry.path().string());
+            std::filesystem::remove(entry.path(), ec);
+            continue;
+        }
+
+        if (entry.path().extension() == ".bin")
+            m_used += entry.file_size(ec);
+    }
+}
+
+std::optional<std::string> CDiskCache::defaultDir() {
+    const auto XDG = getenv("XDG_CACHE_HOME");
+    if (XDG && XDG[0] != '\0')
+        return std::string{XDG} + "/hyprpaper";
+
+    const auto HOME = getenv("HOME");
+    if (HOME && HOME[0] != '\0')
+        return std::string{HOME} + "/.cache/hyprpaper";
+
+    return std::nullopt;
+}
+
+std::string CDiskCache::entryPath(const SImageKey& key) const {
+    uint64_t   h       = 0xcbf29ce484222325ULL;
+    const auto FITMODE = sc<uint32_t>(key.fitMode);
+
+    h = fnv1a(h, key.path.data(), key.path.size());
+    h = fnv1a(h, &key.mtime, sizeof(key.mtime));
+    h = fnv1a(h, &key.fileSize, sizeof(key.fileSize));
+    h = fnv1a(h, &key.width, sizeof(key.width));
+    h = fnv1a(h, &key.height, sizeof(key.height));
+    h = fnv1a(h, &FITMODE, sizeof(FITMODE));
+
+    return std::format("{}/{:016x}.bin", m_dir, h);
+}
+
+SP<CDecodedImage> CDiskCache::load(const SImageKey& key) {
+    const auto PATH = entryPath(key);
+    const int  FD   = open(PATH.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (FD < 0)
+        return nullptr;
+
+    Hyprutils::Utils::CScopeGuard x([FD] { close(FD); });
+
+    struct stat                   st;
+    if (fstat(FD, &st) != 0 || sc<size_t>(st.st_size) < sizeof(SEntryHeader))
+        return nullptr;
+
+    const size_t LEN = st.st_size;
+    auto* const  MAP = mmap(nullptr, LEN, PROT_READ | PROT_WRITE, MAP_PRIVATE, FD, 0);
+
+    if (MAP == MAP_FAILED)
+        return nullptr;
+
+    const auto* const HEADER = sc<const SEntryHeader*>(MAP);
+    const auto* const PATHIN = sc<const char*>(MAP) + sizeof(SEntryHeader);
+    const auto        FORMAT = sc<cairo_format_t>(HEADER->format);
+
+    const bool        VALID = HEADER->magic == ENTRY_MAGIC && HEADER->version == ENTRY_VERSION && HEADER->mtime == key.mtime && HEADER->fileSize == key.fileSize &&
+        HEADER->outputW == key.width && HEADER->outputH == key.height && HEADER->fitMode == sc<uint32_t>(key.fitMode) && HEADER->pathLen == key.path.size() &&
+        sizeof(SEntryHeader) + HEADER->pathLen <= LEN && std::string_view{PATHIN, HEADER->pathLen} == key.path &&
+        (FORMAT == CAIRO_FORMAT_ARGB32 || FORMAT == CAIRO_FORMAT_RGB24) && HEADER->stride == sc<uint32_t>(cairo_format_stride_for_width(FORMAT, HEADER->width)) &&
+        HEADER->dataOffset + sc<uint64_t>(HEADER->stride) * HEADER->height <= LEN;
+
+    if (!VALID) {
+        g_logger->log(LOG_DEBUG, "CDiskCache: dropping invalid entry {}", PATH);
+        munmap(MAP, LEN);
+        unlink(PATH.c_str());
+        return nullptr;
+    }
+
+    madvise(MAP, LEN, MADV_WILLNEED);
+
+    const auto SURFACE = cairo_image_surface_create_for_data(sc<unsigned char*>(MAP) + HEADER->dataOffset, FORMAT, HEADER->width, HEADER->height, HEADER->stride);
+
+    if (cairo_surface_status(SURFACE) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(SURFACE);
+        munmap(MAP, LEN);
+        return nullptr;
+    }
+
+    // the mapping lives as long as the surface does
+    cairo_surface_set_user_data(SURFACE, &MAPPING_KEY, new SMapping{.addr = MAP, .len = LEN}, unmapEntry);
+
+    // bump for LRU
+    futimens(FD, nullptr);
+
+    return makeShared<CDecodedImage>(key.path, makeShared<Hyprgraphics::CCairoSurface>(SURFACE));
+}
+
+void CDiskCache::store(const SImageKey& key, cairo_surface_t* surface) {
+    const auto PATH    = entryPath(key);
+    const auto TMPPATH = std::format("{}.{}.tmp", PATH, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+    SEntryHeader header{
+        .mtime    = key.mtime,
+        .fileSize = key.fileSize,
+        .outputW  = key.width,
+        .outputH  = key.height,
+        .fitMode  = sc<uint32_t>(key.fitMode),
+        .pathLen  = sc<uint32_t>(key.path.size()),
+        .width    = sc<uint32_t>(cairo_image_surface_get_width(surface)),
+        .height   = sc<uint32_t>(cairo_image_surface_get_height(surface)),
+        .stride   = sc<uint32_t>(cairo_image_surface_get_stride(surface)),
+        .format   = sc<uint32_t>(cairo_image_surface_get_format(surface)),
+    };
+
+    header.dataOffset = ((sizeof(SEntryHeader) + key.path.size() + DATA_ALIGN - 1) / DATA_ALIGN) * DATA_ALIGN;
+
+    const int FD = open(TMPPATH.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (FD < 0) {
+        g_logger->log(LOG_DEBUG, "CDiskCache: can't write {}", TMPPATH);
+        return;
+    }
+
+    const std::vector<uint8_t> PADDING(header.dataOffset - sizeof(SEntryHeader) - key.path.size(), 0);
+
+    bool                       ok = writeAll(FD, &header, sizeof(header));
+    ok                            = ok && writeAll(FD, key.path.data(), key.path.size());
+    ok                            = ok && writeAll(FD, PADDING.data(), PADDING.size());
+    ok                            = ok && writeAll(FD, cairo_image_surface_get_data(surface), sc<size_t>(header.stride) * header.height);
+
+    close(FD);
+
+    // replacing an entry doesn't grow the cache
+    struct stat old;
+    const auto  OLDSIZE = stat(PATH.c_str(), &old) == 0 ? sc<size_t>(old.st_size) : 0;
+
+    if (!ok || rename(TMPPATH.c_str(), PATH.c_str()) != 0) {
+        unlink(TMPPATH.c_str());
+        return;
+    }
+
+    std::lock_guard lg(m_evictMutex);
+
+    m_used = m_used + header.dataOffset + (sc<size_t>(header.stride) * header.height) - std::min(OLDSIZE, m_used);
+
+    if (m_used > m_budget)
+        evict();
+}
+
+// m_evictMutex must be held
+void CDiskCache::evict() {
+    struct SFile {
+        std::filesystem::path           path;
+        std::filesystem::file_time_type lastUsed;
+        size_t                          size = 0;
+    };
+
+    std::vector<SFile> files;
+    size_t             total = 0;
+    std::error_code    ec;
+
+    for (const auto& entry : std::filesystem::directory_iterator(m_dir, ec)) {
+        if (!entry.is_regular_file(ec) || entry.path().extension() != ".bin")
+            continue;
+
+        const auto SIZE = entry.file_size(ec);
+        if (ec)
+            continue;
+
+        files.emplace_back(SFile{.path = entry.path(), .lastUsed = entry.last_write_time(ec), .size = SIZE});
+        total += SIZE;
+    }
+
+    m_used = total;
+
+    if (total <= m_budget)
+        return;
+
+    std::ranges::sort(files, [](const auto& a, const auto& b) { return a.lastUsed < b.lastUsed; });
+
+    // some headroom, so a full cache isn't walked again on the very next store
+    const size_t TARGET = m_budget / 10 * 9;
+
+    for (const auto& f : files) {
+        if (total <= TARGET)
+            break;
+
+        g_logger->log(LOG_TRACE, "CDiskCache: evicting {}", f.path.string());
+
+        std::filesystem::remove(f.path, ec);
+        total -= f.size;
+    }
+
+    m_used = total;
+}
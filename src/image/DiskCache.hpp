@@ -0,0 +1,42 @@
+#pragma once
+
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "DecodedImage.hpp"
+#include "ImageKey.hpp"
+
+// On-disk cache of decoded and scaled pixels, so a warm start only has to page them in.
+// Entries are named after their key, so a changed source (mtime / size) simply misses
+// and the stale entry ages out. Thread-safe, used from the decode workers.
+// The cache's size is tracked as entries are written, the directory is only walked
+// when it runs over budget.
+class CDiskCache {
+  public:
+    CDiskCache(std::string dir, size_t budget);
+    ~CDiskCache() = default;
+
+    CDiskCache(const CDiskCache&) = delete;
+    CDiskCache(CDiskCache&)       = delete;
+    CDiskCache(CDiskCache&&)      = delete;
+
+    static std::optional<std::string> defaultDir();
+
+    SP<CDecodedImage>                 load(const SImageKey& key);
+    // only reads surface, which may be on screen already
+    void                              store(const SImageKey& key, cairo_surface_t* surface);
+
+  private:
+    std::string entryPath(const SImageKey& key) const;
+    void        scan();
+    void        evict();
+
+    std::string m_dir;
+    size_t      m_budget = 0;
+
+    std::mutex  m_evictMutex;
+    size_t      m_used = 0; // bytes, guarded by m_evictMutex
+};
+
+inline UP<CDiskCache> g_diskCache;
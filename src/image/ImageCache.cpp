@@ -0,0 +1,215 @@
+#include "ImageCache.hpp"
+#include "../helpers/Logger.hpp"
+#include "../helpers/Stats.hpp"
+
+#include <filesystem>
+
+CImageRequest::CImageRequest(const SImageKey& key, Callback&& cb) : m_key(key), m_callback(std::move(cb)) {
+    ;
+}
+
+CImageRequest::~CImageRequest() {
+    if (g_imageCache)
+        g_imageCache->cancel(m_key);
+}
+
+CImageCache::CImageCache(size_t budget) : m_budget(budget) {
+    ;
+}
+
+std::string CImageCache::canonicalPath(const std::string& path) {
+    std::error_code ec;
+    auto            canonical = std::filesystem::weakly_canonical(path, ec);
+    return ec ? path : canonical.string();
+}
+
+SImageKey CImageCache::keyFor(const std::string& path, const Hyprutils::Math::Vector2D& size, Hyprtoolkit::eImageFitMode fitMode) const {
+    SImageKey key{
+        .path    = path,
+        .width   = sc<uint32_t>(std::max(size.x, 0.0)),
+        .height  = sc<uint32_t>(std::max(size.y, 0.0)),
+        .fitMode = fitMode,
+    };
+
+    // a tile is kept at its own size and repeated by the renderer, so one copy serves every output
+    if (fitMode == Hyprtoolkit::IMAGE_FIT_MODE_TILE)
+        key.width = key.height = 0;
+
+    const auto CANONICAL = m_canonical.find(path);
+    if (CANONICAL == m_canonical.end())
+        return key;
+
+    const auto VERSION = m_versions.find(CANONICAL->second);
+    if (VERSION == m_versions.end())
+        return key;
+
+    key.path     = CANONICAL->second;
+    key.mtime    = VERSION->second.mtime;
+    key.fileSize = VERSION->second.fileSize;
+    return key;
+}
+
+void CImageCache::forget(const std::string& path) {
+    if (const auto IT = m_canonical.find(path); IT != m_canonical.end()) {
+        m_versions.erase(IT->second);
+        m_canonical.erase(IT);
+    }
+
+    m_versions.erase(path);
+}
+
+SP<CDecodedImage> CImageCache::get(const SImageKey& key) {
+    const auto IT = m_entries.find(key);
+
+    if (IT == m_entries.end()) {
+        statsAdd(g_stats->cache.misses);
+        return nullptr;
+    }
+
+    statsAdd(g_stats->cache.hits);
+
+    IT->second.lastUsed = ++m_useClock;
+    return IT->second.image;
+}
+
+SP<CImageRequest> CImageCache::load(const SImageKey& key, CImageRequest::Callback&& cb) {
+    auto request = makeShared<CImageRequest>(key, std::move(cb));
+
+    if (const auto IT = m_pending.find(key); IT != m_pending.end()) {
+        IT->second.waiters.emplace_back(request);
+        return request;
+    }
+
+    auto& pending = m_pending[key];
+    pending.waiters.emplace_back(request);
+    pending.job = g_decodePool->decode(key, [this, key](SP<CDecodedImage> image, const SImageKey& resolved) { onDecoded(key, resolved, std::move(image)); });
+
+    return request;
+}
+
+void CImageCache::cancel(const SImageKey& key) {
+    const auto IT = m_pending.find(key);
+    if (IT == m_pending.end())
+        return;
+
+    std::erase_if(IT->second.waiters, [](const auto& w) { return w.expired(); });
+
+    // dropping the job takes it off the queue, nobody would look at the result
+    if (IT->second.waiters.empty())
+        m_pending.erase(IT);
+}
+
+void CImageCache::onDecoded(const SImageKey& key, const SImageKey& resolved, SP<CDecodedImage> image) {
+    const auto IT = m_pending.find(key);
+    if (IT == m_pending.end())
+        return;
+
+    auto waiters = std::move(IT->second.waiters);
+    m_pending.erase(IT);
+
+    // from now on keyFor() gives the resolved key, and get() hits without a decode
+    if (resolved.isResolved()) {
+        m_canonical[key.path]     = resolved.path;
+        m_versions[resolved.path] = SFileVersion{.mtime = resolved.mtime, .fileSize = resolved.fileSize};
+    }
+
+    if (image) {
+        // another spelling of the same file, or a forgotten one that didn't change
+        if (const auto ENTRY = m_entries.find(resolved); ENTRY != m_entries.end()) {
+            image                  = ENTRY->second.image;
+            ENTRY->second.lastUsed = ++m_useClock;
+        } else {
+            m_resident += image->bytes();
+            m_entries[resolved] = SEntry{.image = image, .lastUsed = ++m_useClock};
+            g_stats->cache.residentBytes.store(m_resident, std::memory_order_relaxed);
+        }
+    }
+
+    for (const auto& w : waiters) {
+        const auto REQUEST = w.lock();
+        if (!REQUEST || !REQUEST->m_callback)
+            continue;
+
+        auto cb = std::move(REQUEST->m_callback);
+        cb(image);
+    }
+
+    evict();
+}
+
+void CImageCache::evict() {
+    while (m_resident > m_budget) {
+        auto victim = m_entries.end();
+
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            // still on screen (or waiting to be), can't be freed anyway
+            if (it->second.image.strongRef() > 1 || m_pinned.contains(it->first.path))
+                continue;
+
+            if (victim == m_entries.end() || it->second.lastUsed < victim->second.lastUsed)
+                victim = it;
+        }
+
+        if (victim == m_entries.end())
+            break;
+
+        g_logger->log(LOG_TRACE, "CImageCache: evicting {} ({} bytes)", victim->first.path, victim->second.image->bytes());
+
+        m_resident -= victim->second.image->bytes();
+        m_entries.erase(victim);
+    }
+
+    g_stats->cache.residentBytes.store(m_resident, std::memory_order_relaxed);
+}
+
+size_t CImageCache::residentBytes() const {
+    return m_resident;
+}
+
+void CImageCache::pin(const std::string& path) {
+    m_pinned.emplace(canonicalPath(path));
+}
+
+void CImageCache::unpin(const std::string& path) {
+    const auto CANONICAL = canonicalPath(path);
+
+    if (m_pinned.erase(CANONICAL) > 0)
+        release(CANONICAL);
+}
+
+void CImageCache::unpinAll() {
+    auto pinned = std::move(m_pinned);
+    m_pinned.clear();
+
+    for (const auto& p : pinned) {
+        release(p);
+    }
+}
+
+void CImageCache::release(const std::string& path) {
+    std::erase_if(m_entries, [this, &path](const auto& e) {
+        if (e.first.path != path || e.second.image.strongRef() > 1)
+            return false;
+
+        m_resident -= e.second.image->bytes();
+        return true;
+    });
+
+    g_stats->cache.residentBytes.store(m_resident, std::memory_order_relaxed);
+}
+
+std::vector<CImageCache::SEntryInfo> CImageCache::entries() const {
+    std::vector<SEntryInfo> result;
+    result.reserve(m_entries.size());
+
+    for (const auto& [key, entry] : m_entries) {
+        result.emplace_back(SEntryInfo{
+            .key    = key,
+            .bytes  = entry.image->bytes(),
+            .pinned = m_pinned.contains(key.path),
+            .inUse  = entry.image.strongRef() > 1,
+        });
+    }
+
+    return result;
+}
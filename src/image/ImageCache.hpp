@@ -0,0 +1,107 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "DecodePool.hpp"
+#include "ImageKey.hpp"
+
+// A pending cache load. Same as with decode jobs, dropping it cancels the callback,
+// and the decode too once nobody else waits for it.
+class CImageRequest {
+  public:
+    using Callback = std::function<void(SP<CDecodedImage>)>;
+
+    CImageRequest(const SImageKey& key, Callback&& cb);
+    ~CImageRequest();
+
+  private:
+    SImageKey m_key;
+    Callback  m_callback;
+
+    friend class CImageCache;
+};
+
+// Process-wide cache of decoded images. Targets showing the same image at the same
+// size share one buffer, and concurrent loads of one key share one decode.
+// Images no longer referenced by anyone are kept around within the byte budget.
+class CImageCache {
+  public:
+    CImageCache(size_t budget);
+    ~CImageCache() = default;
+
+    CImageCache(const CImageCache&) = delete;
+    CImageCache(CImageCache&)       = delete;
+    CImageCache(CImageCache&&)      = delete;
+
+    // Tiles get a 0x0 size, so all outputs share them. Doesn't touch the disk: a path no decode
+    // has resolved yet gets an unresolved key, which always misses and is resolved by load().
+    SImageKey          keyFor(const std::string& path, const Hyprutils::Math::Vector2D& size, Hyprtoolkit::eImageFitMode fitMode) const;
+    static std::string canonicalPath(const std::string& path);
+
+    // the file may have changed, its next load looks at it again
+    void               forget(const std::string& path);
+
+    // returns the image if it's resident, nullptr otherwise
+    SP<CDecodedImage> get(const SImageKey& key);
+
+    // decodes the image (or joins an in-flight decode of the same key)
+    SP<CImageRequest> load(const SImageKey& key, CImageRequest::Callback&& cb);
+
+    size_t            residentBytes() const;
+
+    // pinned paths are never evicted, at any size, until unpinned
+    void              pin(const std::string& path);
+    void              unpin(const std::string& path);
+    void              unpinAll();
+
+    struct SEntryInfo {
+        SImageKey key;
+        size_t    bytes  = 0;
+        bool      pinned = false;
+        bool      inUse  = false;
+    };
+
+    std::vector<SEntryInfo> entries() const;
+
+  private:
+    struct SEntry {
+        SP<CDecodedImage> image;
+        uint64_t          lastUsed = 0;
+    };
+
+    struct SPending {
+        SP<CDecodeJob>                 job;
+        std::vector<WP<CImageRequest>> waiters;
+    };
+
+    struct SFileVersion {
+        int64_t  mtime    = 0;
+        uint64_t fileSize = 0;
+    };
+
+    void                                    onDecoded(const SImageKey& key, const SImageKey& resolved, SP<CDecodedImage> image);
+    // a request went away, drops the decode if it was the last one waiting
+    void                                    cancel(const SImageKey& key);
+    void                                    evict();
+    // drops whatever of path nobody is showing, regardless of the budget
+    void                                    release(const std::string& path);
+
+    size_t                                  m_budget   = 0;
+    size_t                                  m_resident = 0;
+    uint64_t                                m_useClock = 0;
+
+    std::unordered_map<SImageKey, SEntry>   m_entries;
+    std::unordered_map<SImageKey, SPending> m_pending;
+    std::unordered_set<std::string>         m_pinned;
+
+    // what the decode workers resolved: path as asked for -> canonical -> version
+    std::unordered_map<std::string, std::string>  m_canonical;
+    std::unordered_map<std::string, SFileVersion> m_versions;
+
+    friend class CImageRequest;
+};
+
+inline UP<CImageCache> g_imageCache;
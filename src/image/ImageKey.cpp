@@ -0,0 +1,25 @@
+#include "ImageKey.hpp"
+
+#include <filesystem>
+#include <sys/stat.h>
+
+SImageKey SImageKey::resolved() const {
+    SImageKey       key = *this;
+
+    std::error_code ec;
+    if (auto canonical = std::filesystem::weakly_canonical(path, ec); !ec)
+        key.path = canonical.string();
+
+    struct stat st;
+    if (stat(key.path.c_str(), &st) == 0) {
+        key.mtime    = sc<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+        key.fileSize = sc<uint64_t>(st.st_size);
+    }
+
+    return key;
+}
+
+bool SImageKey::isResolved() const {
+    // a file that's there has an mtime
+    return mtime != 0 || fileSize != 0;
+}
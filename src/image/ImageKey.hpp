@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <hyprtoolkit/element/Image.hpp>
+#include <hyprutils/memory/Casts.hpp>
+
+#include "../helpers/Memory.hpp"
+
+// Identifies a decoded image: the source file (and its version) plus the
+// output size and fit mode it was scaled for. Tiles aren't scaled, so their
+// size is always 0x0 and every output shares the same one.
+struct SImageKey {
+    std::string                path; // canonical once resolved
+    int64_t                    mtime    = 0;
+    uint64_t                   fileSize = 0;
+    uint32_t                   width    = 0;
+    uint32_t                   height   = 0;
+    Hyprtoolkit::eImageFitMode fitMode  = Hyprtoolkit::IMAGE_FIT_MODE_COVER;
+
+    bool                       operator==(const SImageKey&) const = default;
+
+    // canonical path and file version filled in, touches the disk so only decode workers call it
+    SImageKey                  resolved() const;
+    bool                       isResolved() const;
+};
+
+template <>
+struct std::hash<SImageKey> {
+    size_t operator()(const SImageKey& k) const {
+        size_t h = std::hash<std::string>{}(k.path);
+        h ^= std::hash<int64_t>{}(k.mtime) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= std::hash<uint64_t>{}(k.fileSize) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= std::hash<uint64_t>{}((sc<uint64_t>(k.width) << 32) | k.height) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= std::hash<int>{}(k.fitMode) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+};
@@ -0,0 +1,130 @@
+#include "JpegDecoder.hpp"
+#include "Scaler.hpp"
+
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+
+#include <hyprutils/memory/Casts.hpp>
+#include <hyprutils/utils/ScopeGuard.hpp>
+
+using namespace Hyprutils::Math;
+
+// cairo's RGB24 is a native-endian 0xXXRRGGBB word, libjpeg-turbo writes it directly
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+constexpr const J_COLOR_SPACE CAIRO_COLOR_SPACE = JCS_EXT_BGRX;
+#else
+constexpr const J_COLOR_SPACE CAIRO_COLOR_SPACE = JCS_EXT_XRGB;
+#endif
+
+namespace {
+    struct SErrorManager {
+        jpeg_error_mgr pub;
+        jmp_buf        jump;
+        char           message[JMSG_LENGTH_MAX] = {0};
+    };
+}
+
+static void onError(j_common_ptr info) {
+    auto* const ERR = rc<SErrorManager*>(info->err);
+    info->err->format_message(info, ERR->message);
+    longjmp(ERR->jump, 1);
+}
+
+static void onMessage(j_common_ptr info) {
+    ; // corrupt data warnings, the image is still usable
+}
+
+// libjpeg errors longjmp back to the setjmp below, so nothing with a destructor may be alive across its calls
+static std::expected<SP<CDecodedImage>, std::string> decode(FILE* file, const std::string& path, const Vector2D& output, Hyprtoolkit::eImageFitMode fitMode) {
+    jpeg_decompress_struct    info;
+    SErrorManager             err;
+    cairo_surface_t* volatile surface = nullptr;
+
+    info.err               = jpeg_std_error(&err.pub);
+    err.pub.error_exit     = onError;
+    err.pub.output_message = onMessage;
+
+    if (setjmp(err.jump)) {
+        if (surface)
+            cairo_surface_destroy(surface);
+
+        jpeg_destroy_decompress(&info);
+        return std::unexpected(std::string{err.message});
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_stdio_src(&info, file);
+    jpeg_read_header(&info, TRUE);
+
+    const auto TARGET = Scaler::targetSize({sc<double>(info.image_width), sc<double>(info.image_height)}, output, fitMode);
+
+    // the largest reduction still covering the target, the scaler does the rest at full quality
+    unsigned denom = 1;
+    info.scale_num = 1;
+
+    for (const unsigned D : {8U, 4U, 2U}) {
+        info.scale_denom = D;
+        jpeg_calc_output_dimensions(&info);
+
+        if (info.output_width >= TARGET.x && info.output_height >= TARGET.y) {
+            denom = D;
+            break;
+        }
+    }
+
+    if (denom == 1) {
+        jpeg_destroy_decompress(&info);
+        return nullptr;
+    }
+
+    info.scale_denom     = denom;
+    info.out_color_space = CAIRO_COLOR_SPACE;
+
+    jpeg_start_decompress(&info);
+
+    surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, sc<int>(info.output_width), sc<int>(info.output_height));
+
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        jpeg_destroy_decompress(&info);
+        return std::unexpected("failed to allocate the surface");
+    }
+
+    cairo_surface_flush(surface);
+
+    auto* const DATA   = cairo_image_surface_get_data(surface);
+    const auto  STRIDE = sc<size_t>(cairo_image_surface_get_stride(surface));
+
+    // straight into the surface, no intermediate buffer
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = DATA + (sc<size_t>(info.output_scanline) * STRIDE);
+        jpeg_read_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+
+    cairo_surface_mark_dirty(surface);
+
+    return makeShared<CDecodedImage>(path, makeShared<Hyprgraphics::CCairoSurface>(surface));
+}
+
+std::expected<SP<CDecodedImage>, std::string> JpegDecoder::decodeScaled(const std::string& path, const Vector2D& output, Hyprtoolkit::eImageFitMode fitMode) {
+    FILE* file = fopen(path.c_str(), "rbe");
+
+    // the regular decoders will report it
+    if (!file)
+        return nullptr;
+
+    Hyprutils::Utils::CScopeGuard x([file] { fclose(file); });
+
+    uint8_t magic[3] = {0};
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || magic[0] != 0xFF || magic[1] != 0xD8 || magic[2] != 0xFF)
+        return nullptr;
+
+    rewind(file);
+
+    return decode(file, path, output, fitMode);
+}
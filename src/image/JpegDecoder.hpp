@@ -0,0 +1,17 @@
+#pragma once
+
+#include <expected>
+#include <string>
+
+#include <hyprtoolkit/element/Image.hpp>
+#include <hyprutils/math/Vector2D.hpp>
+
+#include "DecodedImage.hpp"
+
+// libjpeg-turbo can decode at 1/2, 1/4 or 1/8 size by dropping DCT coefficients, which is
+// way cheaper than decoding everything and scaling it down afterwards.
+namespace JpegDecoder {
+    // Decodes at the smallest scale that still covers Scaler::targetSize(). Returns nullptr
+    // if path isn't a JPEG or would be decoded at full size anyway, the regular decoders handle that.
+    std::expected<SP<CDecodedImage>, std::string> decodeScaled(const std::string& path, const Hyprutils::Math::Vector2D& output, Hyprtoolkit::eImageFitMode fitMode);
+};
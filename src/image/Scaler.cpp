@@ -0,0 +1,87 @@
+#include "Scaler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <pixman.h>
+#include <hyprutils/memory/Casts.hpp>
+
+using namespace Hyprutils::Math;
+
+Vector2D Scaler::targetSize(const Vector2D& source, const Vector2D& output, Hyprtoolkit::eImageFitMode fitMode) {
+    if (output.x <= 0 || output.y <= 0 || source.x <= 0 || source.y <= 0)
+        return source;
+
+    switch (fitMode) {
+        // repeated as-is, the source is the tile
+        case Hyprtoolkit::IMAGE_FIT_MODE_TILE: return source;
+        case Hyprtoolkit::IMAGE_FIT_MODE_STRETCH: return {std::min(source.x, output.x), std::min(source.y, output.y)};
+        case Hyprtoolkit::IMAGE_FIT_MODE_CONTAIN:
+        case Hyprtoolkit::IMAGE_FIT_MODE_COVER: {
+            const double SX    = output.x / source.x;
+            const double SY    = output.y / source.y;
+            const double SCALE = fitMode == Hyprtoolkit::IMAGE_FIT_MODE_COVER ? std::max(SX, SY) : std::min(SX, SY);
+
+            if (SCALE >= 1.0)
+                return source;
+
+            return {std::ceil(source.x * SCALE), std::ceil(source.y * SCALE)};
+        }
+        default: break;
+    }
+
+    return source;
+}
+
+std::expected<SP<CDecodedImage>, std::string> Scaler::scale(const SP<CDecodedImage>& source, const Vector2D& output, Hyprtoolkit::eImageFitMode fitMode) {
+    const auto SOURCESIZE = source->size();
+    const auto TARGETSIZE = targetSize(SOURCESIZE, output, fitMode);
+
+    if (TARGETSIZE == SOURCESIZE)
+        return source;
+
+    const auto SRC    = source->surface()->cairo();
+    const auto FORMAT = cairo_image_surface_get_format(SRC);
+
+    if (FORMAT != CAIRO_FORMAT_ARGB32 && FORMAT != CAIRO_FORMAT_RGB24)
+        return std::unexpected("unsupported surface format for scaling");
+
+    const auto DST = cairo_image_surface_create(FORMAT, sc<int>(TARGETSIZE.x), sc<int>(TARGETSIZE.y));
+    if (cairo_surface_status(DST) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(DST);
+        return std::unexpected("failed to allocate the scaled surface");
+    }
+
+    cairo_surface_flush(SRC);
+
+    const auto PIXFORMAT = FORMAT == CAIRO_FORMAT_ARGB32 ? PIXMAN_a8r8g8b8 : PIXMAN_x8r8g8b8;
+    const auto PSRC      = pixman_image_create_bits(PIXFORMAT, sc<int>(SOURCESIZE.x), sc<int>(SOURCESIZE.y), rc<uint32_t*>(cairo_image_surface_get_data(SRC)),
+                                                    cairo_image_surface_get_stride(SRC));
+    const auto PDST      = pixman_image_create_bits(PIXFORMAT, sc<int>(TARGETSIZE.x), sc<int>(TARGETSIZE.y), rc<uint32_t*>(cairo_image_surface_get_data(DST)),
+                                                    cairo_image_surface_get_stride(DST));
+
+    const auto SCALEX = pixman_double_to_fixed(SOURCESIZE.x / TARGETSIZE.x);
+    const auto SCALEY = pixman_double_to_fixed(SOURCESIZE.y / TARGETSIZE.y);
+
+    pixman_transform_t transform;
+    pixman_transform_init_scale(&transform, SCALEX, SCALEY);
+    pixman_image_set_transform(PSRC, &transform);
+    // the kernel reaches past the edges, which would pull transparent black into the border pixels
+    pixman_image_set_repeat(PSRC, PIXMAN_REPEAT_PAD);
+
+    // box-sampled separable convolution, i.e. proper area averaging instead of bilinear aliasing
+    int   nParams = 0;
+    auto* params  = pixman_filter_create_separable_convolution(&nParams, SCALEX, SCALEY, PIXMAN_KERNEL_LINEAR, PIXMAN_KERNEL_LINEAR, PIXMAN_KERNEL_BOX, PIXMAN_KERNEL_BOX, 2, 2);
+    pixman_image_set_filter(PSRC, PIXMAN_FILTER_SEPARABLE_CONVOLUTION, params, nParams);
+    free(params);
+
+    pixman_image_composite32(PIXMAN_OP_SRC, PSRC, nullptr, PDST, 0, 0, 0, 0, 0, 0, sc<int>(TARGETSIZE.x), sc<int>(TARGETSIZE.y));
+
+    pixman_image_unref(PSRC);
+    pixman_image_unref(PDST);
+
+    cairo_surface_mark_dirty(DST);
+
+    return makeShared<CDecodedImage>(source->path(), makeShared<Hyprgraphics::CCairoSurface>(DST));
+}
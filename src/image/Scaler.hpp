@@ -0,0 +1,15 @@
+#pragma once
+
+#include <hyprtoolkit/element/Image.hpp>
+#include <hyprutils/math/Vector2D.hpp>
+
+#include "DecodedImage.hpp"
+
+namespace Scaler {
+    // The size an image needs in memory to be shown on an output of the given size.
+    // Never larger than the source: upscaling is left to the renderer.
+    Hyprutils::Math::Vector2D                     targetSize(const Hyprutils::Math::Vector2D& source, const Hyprutils::Math::Vector2D& output, Hyprtoolkit::eImageFitMode fitMode);
+
+    // Downscales an image to targetSize(). Returns the source image if no scaling is needed.
+    std::expected<SP<CDecodedImage>, std::string> scale(const SP<CDecodedImage>& source, const Hyprutils::Math::Vector2D& output, Hyprtoolkit::eImageFitMode fitMode);
+};
@@ -7,13 +7,18 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstring>
 #include <format>
 
 #include <hyprutils/memory/Casts.hpp>
 
 using namespace Hyprutils::Memory;
 
-static int getUID() {
+constexpr const auto   REPLY_TIMEOUT = std::chrono::seconds(5);
+constexpr const size_t READ_CHUNK    = 8192;
+
+static int             getUID() {
     const auto UID   = getuid();
     const auto PWUID = getpwuid(UID);
     return PWUID ? PWUID->pw_uid : UID;
@@ -30,57 +35,125 @@ static std::string getRuntimeDir() {
     return std::string{XDG} + "/hypr";
 }
 
-std::expected<std::string, std::string> HyprlandSocket::getFromSocket(const std::string& cmd) {
-    static const auto HIS = getenv("HYPRLAND_INSTANCE_SIGNATURE");
+HyprlandSocket::CRequest::CRequest(SP<IBackend> backend, Callback&& cb) : m_backend(backend), m_callback(std::move(cb)) {
+    ;
+}
 
-    if (!HIS || HIS[0] == '\0')
-        return std::unexpected("HYPRLAND_INSTANCE_SIGNATURE empty: are we under hyprland?");
+HyprlandSocket::CRequest::~CRequest() {
+    if (m_timeout && !m_timeout->passed())
+        m_timeout->cancel();
 
-    const auto SERVERSOCKET = socket(AF_UNIX, SOCK_STREAM, 0);
+    closeFd();
+}
 
-    auto       t = timeval{.tv_sec = 5, .tv_usec = 0};
-    setsockopt(SERVERSOCKET, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(struct timeval));
+void HyprlandSocket::CRequest::closeFd() {
+    if (m_fd < 0)
+        return;
 
-    if (SERVERSOCKET < 0)
-        return std::unexpected("couldn't open a socket (1)");
+    // we may be inside the fd's own callback, leave the removal to the loop
+    m_backend->addIdle([backend = m_backend, fd = m_fd] {
+        backend->removeFd(fd);
+        close(fd);
+    });
 
-    sockaddr_un serverAddress = {0};
-    serverAddress.sun_family  = AF_UNIX;
+    m_fd = -1;
+}
 
-    std::string socketPath = getRuntimeDir() + "/" + HIS + "/.socket.sock";
+void HyprlandSocket::CRequest::onReadable() {
+    if (m_fd < 0)
+        return;
 
-    strncpy(serverAddress.sun_path, socketPath.c_str(), sizeof(serverAddress.sun_path) - 1);
+    // straight into the reply, it's read until hyprland closes the connection
+    while (true) {
+        const auto OLDSIZE = m_reply.size();
+        m_reply.resize(OLDSIZE + READ_CHUNK);
 
-    if (connect(SERVERSOCKET, rc<sockaddr*>(&serverAddress), SUN_LEN(&serverAddress)) < 0)
-        return std::unexpected(std::format("couldn't connect to the hyprland socket at {}", socketPath));
+        const auto LEN = read(m_fd, m_reply.data() + OLDSIZE, READ_CHUNK);
+        m_reply.resize(OLDSIZE + std::max<ssize_t>(LEN, 0));
 
-    auto sizeWritten = write(SERVERSOCKET, cmd.c_str(), cmd.length());
+        if (LEN > 0)
+            continue;
 
-    if (sizeWritten < 0)
-        return std::unexpected("couldn't write (4)");
+        if (LEN == 0) {
+            finish(std::move(m_reply));
+            return;
+        }
 
-    std::string reply        = "";
-    char        buffer[8192] = {0};
+        if (errno == EINTR)
+            continue;
 
-    sizeWritten = read(SERVERSOCKET, buffer, 8192);
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            finish(std::unexpected(std::format("couldn't read (5): {}", strerror(errno))));
 
-    if (sizeWritten < 0) {
-        if (errno == EWOULDBLOCK)
-            return std::unexpected("Hyprland IPC didn't respond in time");
-        return std::unexpected("couldn't read (5)");
+        return;
     }
+}
 
-    reply += std::string(buffer, sizeWritten);
+void HyprlandSocket::CRequest::finish(Reply&& reply) {
+    if (m_timeout && !m_timeout->passed())
+        m_timeout->cancel();
 
-    while (sizeWritten == 8192) {
-        sizeWritten = read(SERVERSOCKET, buffer, 8192);
-        if (sizeWritten < 0) {
-            return std::unexpected("couldn't read (5)");
-        }
-        reply += std::string(buffer, sizeWritten);
+    m_timeout.reset();
+    closeFd();
+
+    if (!m_callback)
+        return;
+
+    auto cb = std::move(m_callback);
+    m_callback = nullptr;
+    cb(std::move(reply));
+}
+
+SP<HyprlandSocket::CRequest> HyprlandSocket::getFromSocket(SP<IBackend> backend, const std::string& cmd, Callback&& cb) {
+    static const auto HIS = getenv("HYPRLAND_INSTANCE_SIGNATURE");
+
+    auto              request = makeShared<CRequest>(backend, std::move(cb));
+
+    if (!HIS || HIS[0] == '\0') {
+        request->finish(std::unexpected("HYPRLAND_INSTANCE_SIGNATURE empty: are we under hyprland?"));
+        return request;
+    }
+
+    const auto SERVERSOCKET = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (SERVERSOCKET < 0) {
+        request->finish(std::unexpected("couldn't open a socket (1)"));
+        return request;
+    }
+
+    sockaddr_un serverAddress = {0};
+    serverAddress.sun_family  = AF_UNIX;
+
+    std::string socketPath = getRuntimeDir() + "/" + HIS + "/.socket.sock";
+
+    strncpy(serverAddress.sun_path, socketPath.c_str(), sizeof(serverAddress.sun_path) - 1);
+
+    // unix sockets connect right away, or fail with EAGAIN if the backlog is full
+    if (connect(SERVERSOCKET, rc<sockaddr*>(&serverAddress), SUN_LEN(&serverAddress)) < 0) {
+        close(SERVERSOCKET);
+        request->finish(std::unexpected(std::format("couldn't connect to the hyprland socket at {}", socketPath)));
+        return request;
     }
 
-    close(SERVERSOCKET);
+    // a command easily fits the socket buffer, a short write means something's off. No SIGPIPE if hyprland is gone already.
+    if (send(SERVERSOCKET, cmd.c_str(), cmd.length(), MSG_NOSIGNAL) != sc<ssize_t>(cmd.length())) {
+        close(SERVERSOCKET);
+        request->finish(std::unexpected("couldn't write (4)"));
+        return request;
+    }
 
-    return reply;
-}
\ No newline at end of file
+    request->m_fd = SERVERSOCKET;
+    request->m_reply.reserve(READ_CHUNK);
+
+    backend->addFd(SERVERSOCKET, [weak = WP<CRequest>{request}] {
+        if (const auto REQUEST = weak.lock(); REQUEST)
+            REQUEST->onReadable();
+    });
+
+    request->m_timeout = backend->addTimer(REPLY_TIMEOUT, [weak = WP<CRequest>{request}] {
+        if (const auto REQUEST = weak.lock(); REQUEST)
+            REQUEST->finish(std::unexpected("Hyprland IPC didn't respond in time"));
+    });
+
+    return request;
+}
@@ -3,7 +3,40 @@
 #include <string_view>
 #include <string>
 #include <expected>
+#include <functional>
+
+#include "../backend/Backend.hpp"
+#include "../helpers/Memory.hpp"
 
 namespace HyprlandSocket {
-    std::expected<std::string, std::string> getFromSocket(const std::string& cmd);
-};
\ No newline at end of file
+    using Reply    = std::expected<std::string, std::string>;
+    using Callback = std::function<void(Reply)>;
+
+    // A request in flight, read from the event loop. Dropping it cancels the callback.
+    class CRequest {
+      public:
+        CRequest(SP<IBackend> backend, Callback&& cb);
+        ~CRequest();
+
+        CRequest(const CRequest&) = delete;
+        CRequest(CRequest&)       = delete;
+        CRequest(CRequest&&)      = delete;
+
+      private:
+        void         onReadable();
+        void         finish(Reply&& reply);
+        void         closeFd();
+
+        SP<IBackend> m_backend;
+        int          m_fd = -1;
+        std::string  m_reply;
+        Callback     m_callback;
+        SP<ITimer>   m_timeout;
+
+        friend SP<CRequest> getFromSocket(SP<IBackend> backend, const std::string& cmd, Callback&& cb);
+    };
+
+    // Sends cmd to Hyprland without blocking. cb runs once the reply is in, or right away if
+    // the socket can't be reached.
+    SP<CRequest> getFromSocket(SP<IBackend> backend, const std::string& cmd, Callback&& cb);
+};
@@ -2,14 +2,18 @@
 #include "../helpers/Logger.hpp"
 #include "../config/WallpaperMatcher.hpp"
 #include "../ui/UI.hpp"
+#include "../image/ImageCache.hpp"
+#include "../helpers/Stats.hpp"
 
+#include <algorithm>
 #include <filesystem>
+#include <optional>
 
 using namespace IPC;
 using namespace std::string_literals;
 
 constexpr const char*         SOCKET_NAME      = ".hyprpaper.sock";
-constexpr const size_t        HP_PROTO_VERSION = 2;
+constexpr const size_t        HP_PROTO_VERSION = 8;
 
 static SP<CHyprpaperCoreImpl> g_coreImpl;
 
@@ -33,6 +37,20 @@ CWallpaperObject::CWallpaperObject(SP<CHyprpaperWallpaperObject>&& obj) : m_obje
         m_fitMode = f;
     });
 
+    m_object->setColor([this](const char* s) {
+        if (m_inert)
+            m_object->error(HYPRPAPER_CORE_WALLPAPER_ERRORS_INERT_WALLPAPER_OBJECT, "Object is inert");
+
+        m_color = s;
+    });
+
+    m_object->setGradient([this](const char* s) {
+        if (m_inert)
+            m_object->error(HYPRPAPER_CORE_WALLPAPER_ERRORS_INERT_WALLPAPER_OBJECT, "Object is inert");
+
+        m_gradient = s;
+    });
+
     m_object->setMonitorName([this](const char* s) {
         if (m_inert)
             m_object->error(HYPRPAPER_CORE_WALLPAPER_ERRORS_INERT_WALLPAPER_OBJECT, "Object is inert");
@@ -53,45 +71,242 @@ static std::string fitModeToStr(hyprpaperCoreWallpaperFitMode m) {
         case HYPRPAPER_CORE_WALLPAPER_FIT_MODE_CONTAIN: return "contain";
         case HYPRPAPER_CORE_WALLPAPER_FIT_MODE_COVER: return "cover";
         case HYPRPAPER_CORE_WALLPAPER_FIT_MODE_TILE: return "tile";
-        case HYPRPAPER_CORE_WALLPAPER_FIT_MODE_STRETCH: return "fit";
+        case HYPRPAPER_CORE_WALLPAPER_FIT_MODE_STRETCH: return "fill";
         default: return "cover";
     }
 }
 
+static Hyprtoolkit::eImageFitMode toImageFitMode(hyprpaperCoreWallpaperFitMode m) {
+    switch (m) {
+        case HYPRPAPER_CORE_WALLPAPER_FIT_MODE_CONTAIN: return Hyprtoolkit::IMAGE_FIT_MODE_CONTAIN;
+        case HYPRPAPER_CORE_WALLPAPER_FIT_MODE_TILE: return Hyprtoolkit::IMAGE_FIT_MODE_TILE;
+        case HYPRPAPER_CORE_WALLPAPER_FIT_MODE_STRETCH: return Hyprtoolkit::IMAGE_FIT_MODE_STRETCH;
+        default: return Hyprtoolkit::IMAGE_FIT_MODE_COVER;
+    }
+}
+
+static std::optional<hyprpaperCoreApplyingError> validateMonitor(const std::string& monitor) {
+    if (!monitor.empty() && !g_matcher->outputExists(monitor))
+        return HYPRPAPER_CORE_APPLYING_ERROR_INVALID_MONITOR;
+
+    return std::nullopt;
+}
+
+static std::optional<hyprpaperCoreApplyingError> validateWallpaper(const std::string& monitor, const std::string& path) {
+    if (const auto ERR = validateMonitor(monitor); ERR)
+        return ERR;
+
+    if (path.empty() || path[0] != '/')
+        return HYPRPAPER_CORE_APPLYING_ERROR_INVALID_PATH;
+
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec) || ec)
+        return HYPRPAPER_CORE_APPLYING_ERROR_INVALID_PATH;
+
+    return std::nullopt;
+}
+
+static CConfigManager::SSetting makeSetting(std::string&& monitor, const std::string& path, hyprpaperCoreWallpaperFitMode fitMode) {
+    auto playlist = makeShared<CPlaylist>();
+    playlist->add(path);
+
+    return CConfigManager::SSetting{
+        .monitor = std::move(monitor),
+        .fitMode = fitModeToStr(fitMode),
+        .paths   = playlist,
+    };
+}
+
 void CWallpaperObject::apply() {
 
     m_inert = true;
 
-    if (!m_monitor.empty() && !g_matcher->outputExists(m_monitor)) {
-        m_object->sendFailed(HYPRPAPER_CORE_APPLYING_ERROR_INVALID_MONITOR);
+    statsAdd(g_stats->ipc.applies);
+
+    if (!m_color.empty() || !m_gradient.empty()) {
+        applyFill();
         return;
     }
 
-    if (m_path.empty()) {
-        m_object->sendFailed(HYPRPAPER_CORE_APPLYING_ERROR_INVALID_PATH);
+    if (const auto ERR = validateWallpaper(m_monitor, m_path); ERR) {
+        statsAdd(g_stats->ipc.failures);
+        m_object->sendFailed(*ERR);
         return;
     }
 
-    if (m_path[0] != '/') {
-        m_object->sendFailed(HYPRPAPER_CORE_APPLYING_ERROR_INVALID_PATH);
+    g_matcher->addState(makeSetting(std::move(m_monitor), m_path, m_fitMode));
+
+    m_object->sendSuccess();
+}
+
+void CWallpaperObject::applyFill() {
+    if (const auto ERR = validateMonitor(m_monitor); ERR) {
+        statsAdd(g_stats->ipc.failures);
+        m_object->sendFailed(*ERR);
         return;
     }
 
-    std::error_code ec;
-    if (!std::filesystem::exists(m_path, ec) || ec) {
-        m_object->sendFailed(HYPRPAPER_CORE_APPLYING_ERROR_INVALID_PATH);
+    if (!m_color.empty() && !m_gradient.empty()) {
+        statsAdd(g_stats->ipc.failures);
+        m_object->sendFailed(HYPRPAPER_CORE_APPLYING_ERROR_INVALID_COLOR);
+        return;
+    }
+
+    const bool GRADIENT = !m_gradient.empty();
+    auto       fill     = CConfigManager::parseFill(GRADIENT ? m_gradient : m_color, GRADIENT);
+
+    if (!fill) {
+        g_logger->log(LOG_DEBUG, "IPC: invalid fill: {}", fill.error());
+        statsAdd(g_stats->ipc.failures);
+        m_object->sendFailed(HYPRPAPER_CORE_APPLYING_ERROR_INVALID_COLOR);
         return;
     }
 
     g_matcher->addState(CConfigManager::SSetting{
         .monitor = std::move(m_monitor),
         .fitMode = fitModeToStr(m_fitMode),
-        .paths   = std::vector{std::move(m_path)},
+        .fill    = std::move(*fill),
     });
 
     m_object->sendSuccess();
 }
 
+CTransactionObject::CTransactionObject(SP<CHyprpaperTransactionObject>&& obj) : m_object(std::move(obj)) {
+    m_object->setDestroy([this]() { std::erase_if(g_IPCSocket->m_transactionObjects, [this](const auto& e) { return e.get() == this; }); });
+    m_object->setOnDestroy([this]() { std::erase_if(g_IPCSocket->m_transactionObjects, [this](const auto& e) { return e.get() == this; }); });
+
+    m_object->setAdd([this](const char* monitor, const char* path, hyprpaperCoreWallpaperFitMode f) {
+        if (m_inert) {
+            m_object->error(HYPRPAPER_CORE_TRANSACTION_ERRORS_INERT_TRANSACTION_OBJECT, "Object is inert");
+            return;
+        }
+
+        if (f > HYPRPAPER_CORE_WALLPAPER_FIT_MODE_TILE) {
+            m_object->error(HYPRPAPER_CORE_TRANSACTION_ERRORS_INVALID_FIT_MODE, "Invalid fit mode");
+            return;
+        }
+
+        SEntry entry{.monitor = monitor, .path = path, .fitMode = f};
+
+        if (auto it = std::ranges::find_if(m_entries, [&entry](const auto& e) { return e.monitor == entry.monitor; }); it != m_entries.end())
+            *it = std::move(entry);
+        else
+            m_entries.emplace_back(std::move(entry));
+    });
+
+    m_object->setCommit([this]() {
+        if (m_inert) {
+            m_object->error(HYPRPAPER_CORE_TRANSACTION_ERRORS_INERT_TRANSACTION_OBJECT, "Object is inert");
+            return;
+        }
+
+        commit();
+    });
+}
+
+void CTransactionObject::commit() {
+    m_inert = true;
+
+    statsAdd(g_stats->ipc.transactions);
+
+    // all or nothing, check everything first
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        if (const auto ERR = validateWallpaper(m_entries[i].monitor, m_entries[i].path); ERR) {
+            statsAdd(g_stats->ipc.failures);
+            m_object->sendFailed(*ERR, sc<uint32_t>(i));
+            return;
+        }
+    }
+
+    std::vector<CConfigManager::SSetting> settings;
+    settings.reserve(m_entries.size());
+
+    for (auto& e : m_entries) {
+        settings.emplace_back(makeSetting(std::move(e.monitor), e.path, e.fitMode));
+    }
+
+    m_entries.clear();
+
+    // one recalc for everything, and the outputs flip together
+    if (!settings.empty())
+        g_ui->flipTogether([&settings] { g_matcher->addStates(std::move(settings)); });
+
+    m_object->sendSuccess();
+}
+
+// 64 bit values go out as two uints, upper half first
+static uint32_t hi(uint64_t v) {
+    return sc<uint32_t>(v >> 32);
+}
+
+static uint32_t lo(uint64_t v) {
+    return sc<uint32_t>(v);
+}
+
+static void sendCounter(const SP<CHyprpaperStatsObject>& obj, const char* name, uint64_t v) {
+    obj->sendCounter(name, hi(v), lo(v));
+}
+
+static void sendCounter(const SP<CHyprpaperStatsObject>& obj, const char* name, const std::atomic<uint64_t>& v) {
+    sendCounter(obj, name, v.load(std::memory_order_relaxed));
+}
+
+static void sendHistogram(const SP<CHyprpaperStatsObject>& obj, const char* name, const SHistogram& h) {
+    for (size_t i = 0; i < SHistogram::BUCKETS; ++i) {
+        const auto COUNT = h.buckets[i].load(std::memory_order_relaxed);
+
+        if (COUNT == 0)
+            continue;
+
+        obj->sendHistogram(name, sc<uint32_t>(std::min<uint64_t>(SHistogram::upperBound(i), UINT32_MAX)), hi(COUNT), lo(COUNT));
+    }
+}
+
+static void sendStats(const SP<CHyprpaperStatsObject>& obj) {
+    const auto& S = *g_stats;
+
+    sendCounter(obj, "decode.decodes", S.decode.decodes);
+    sendCounter(obj, "decode.failures", S.decode.decodeFailures);
+    sendCounter(obj, "decode.dct_scaled", S.decode.dctScaled);
+    sendCounter(obj, "decode.total_us", S.decode.decodeTotalUs);
+    sendCounter(obj, "decode.max_us", S.decode.decodeMaxUs);
+    sendCounter(obj, "decode.scales", S.decode.scales);
+    sendCounter(obj, "decode.scale_total_us", S.decode.scaleTotalUs);
+    sendCounter(obj, "cache.hits", S.cache.hits);
+    sendCounter(obj, "cache.misses", S.cache.misses);
+    sendCounter(obj, "cache.disk_hits", S.cache.diskHits);
+    sendCounter(obj, "cache.disk_misses", S.cache.diskMisses);
+    sendCounter(obj, "cache.resident_kib", S.cache.residentBytes.load(std::memory_order_relaxed) / 1024);
+    sendCounter(obj, "slideshow.ticks", S.slideshow.ticks);
+    sendCounter(obj, "slideshow.swaps", S.slideshow.swaps);
+    sendCounter(obj, "slideshow.late_swaps", S.slideshow.lateSwaps);
+    sendCounter(obj, "slideshow.late_max_us", S.slideshow.lateMaxUs);
+    sendCounter(obj, "ipc.applies", S.ipc.applies);
+    sendCounter(obj, "ipc.transactions", S.ipc.transactions);
+    sendCounter(obj, "ipc.reloads", S.ipc.reloads);
+    sendCounter(obj, "ipc.preloads", S.ipc.preloads);
+    sendCounter(obj, "ipc.queries", S.ipc.queries);
+    sendCounter(obj, "ipc.failures", S.ipc.failures);
+    sendCounter(obj, "config.loads", S.config.loads);
+    sendCounter(obj, "config.scans", S.config.scans);
+
+    sendHistogram(obj, "decode.decode_us", S.decode.decodeUs);
+    sendHistogram(obj, "decode.scale_us", S.decode.scaleUs);
+    sendHistogram(obj, "present.present_us", S.present.presentUs);
+    sendHistogram(obj, "slideshow.timer_late_us", S.slideshow.timerLateUs);
+    sendHistogram(obj, "config.load_us", S.config.loadUs);
+    sendHistogram(obj, "config.scan_us", S.config.scanUs);
+
+    for (const auto& t : g_ui->targets()) {
+        const auto& FRAMES = t->m_frameStats;
+        const auto  BYTES  = t->residentBytes();
+        obj->sendOutput(t->m_monitorName.c_str(), hi(BYTES), lo(BYTES), hi(FRAMES.presents), lo(FRAMES.presents), hi(FRAMES.transitionFrames), lo(FRAMES.transitionFrames),
+                        hi(FRAMES.wakeups), lo(FRAMES.wakeups));
+    }
+
+    obj->sendDone();
+}
+
 CSocket::CSocket() {
     const auto RTDIR = getenv("XDG_RUNTIME_DIR");
 
@@ -136,10 +351,91 @@ CSocket::CSocket() {
             auto x =
                 m_statusObjects.emplace_back(makeShared<CHyprpaperStatusObject>(m_socket->createObject(weak->getObject()->client(), weak->getObject(), "hyprpaper_status", id)));
 
+            x->setGetFrameStats([weak = WP<CHyprpaperStatusObject>{x}]() {
+                if (!weak)
+                    return;
+
+                statsAdd(g_stats->ipc.queries);
+
+                for (const auto& m : g_ui->targets()) {
+                    const auto& STATS = m->m_frameStats;
+                    weak->sendFrameStats(m->m_monitorName.c_str(), hi(STATS.presents), lo(STATS.presents), hi(STATS.transitionFrames), lo(STATS.transitionFrames),
+                                         hi(STATS.wakeups), lo(STATS.wakeups));
+                }
+            });
+
             for (const auto& m : g_ui->targets()) {
                 x->sendActiveWallpaper(m->m_monitorName.c_str(), m->m_lastPath.c_str());
             }
         });
+
+        manager->setGetStatsObject([this, weak = WP<CHyprpaperCoreManagerObject>{manager}](uint32_t id) {
+            if (!weak)
+                return;
+
+            auto x = m_statsObjects.emplace_back(makeShared<CHyprpaperStatsObject>(m_socket->createObject(weak->getObject()->client(), weak->getObject(), "hyprpaper_stats", id)));
+
+            x->setDestroy([this, weak = WP<CHyprpaperStatsObject>{x}] { std::erase(m_statsObjects, weak); });
+            x->setOnDestroy([this, weak = WP<CHyprpaperStatsObject>{x}] { std::erase(m_statsObjects, weak); });
+
+            x->setGet([weak = WP<CHyprpaperStatsObject>{x}]() {
+                if (!weak)
+                    return;
+
+                statsAdd(g_stats->ipc.queries);
+                sendStats(weak.lock());
+            });
+        });
+
+        manager->setGetTransactionObject([this, weak = WP<CHyprpaperCoreManagerObject>{manager}](uint32_t id) {
+            if (!weak)
+                return;
+
+            m_transactionObjects.emplace_back(makeShared<CTransactionObject>(
+                makeShared<CHyprpaperTransactionObject>(m_socket->createObject(weak->getObject()->client(), weak->getObject(), "hyprpaper_transaction", id))));
+        });
+
+        manager->setPreload([this, weak = WP<CHyprpaperCoreManagerObject>{manager}](const char* path, hyprpaperCoreWallpaperFitMode fitMode) {
+            if (!weak)
+                return;
+
+            statsAdd(g_stats->ipc.preloads);
+            preload(weak.lock(), path, fitMode);
+        });
+
+        manager->setUnload([](const char* path) {
+            if (!path[0])
+                g_imageCache->unpinAll();
+            else
+                g_imageCache->unpin(path);
+        });
+
+        manager->setQueryCache([weak = WP<CHyprpaperCoreManagerObject>{manager}]() {
+            if (!weak)
+                return;
+
+            statsAdd(g_stats->ipc.queries);
+
+            uint64_t total = 0;
+
+            for (const auto& e : g_imageCache->entries()) {
+                weak->sendCacheEntry(e.key.path.c_str(), e.key.width, e.key.height, hi(e.bytes), lo(e.bytes), e.pinned, e.inUse);
+                total += e.bytes;
+            }
+
+            weak->sendCacheDone(hi(total), lo(total));
+        });
+
+        manager->setReload([weak = WP<CHyprpaperCoreManagerObject>{manager}]() {
+            statsAdd(g_stats->ipc.reloads);
+
+            const auto RESULT = g_config->reload();
+
+            if (!weak)
+                return;
+
+            weak->sendReloadDone(RESULT ? "" : RESULT.error().c_str());
+        });
     });
 
     m_socket->addImplementation(g_coreImpl);
@@ -147,6 +443,58 @@ CSocket::CSocket() {
     g_ui->backend()->addFd(m_socket->extractLoopFD(), [this]() { m_socket->dispatchEvents(); });
 }
 
+void CSocket::preload(SP<CHyprpaperCoreManagerObject> manager, const std::string& path, hyprpaperCoreWallpaperFitMode fitMode) {
+    if (validateWallpaper("", path)) {
+        manager->sendPreloadDone(path.c_str(), 0);
+        return;
+    }
+
+    auto job = m_preloads.emplace_back(makeShared<SPreload>(SPreload{.path = path, .manager = manager}));
+
+    g_imageCache->pin(path);
+
+    // once per distinct monitor size, that's what targets will ask for
+    std::vector<SImageKey> keys;
+    for (const auto& o : g_ui->backend()->getOutputs()) {
+        auto key = g_imageCache->keyFor(path, o->pixelSize(), toImageFitMode(fitMode));
+        if (std::ranges::find(keys, key) == keys.end())
+            keys.emplace_back(std::move(key));
+    }
+
+    job->remaining = keys.size();
+
+    for (const auto& key : keys) {
+        if (g_imageCache->get(key)) {
+            job->remaining--;
+            continue;
+        }
+
+        job->requests.emplace_back(g_imageCache->load(key, [this, weak = WP<SPreload>{job}](SP<CDecodedImage> image) {
+            const auto JOB = weak.lock();
+            if (!JOB)
+                return;
+
+            JOB->ok = JOB->ok && image;
+            JOB->remaining--;
+            onPreloadProgress(JOB);
+        }));
+    }
+
+    onPreloadProgress(job);
+}
+
+void CSocket::onPreloadProgress(SP<SPreload> job) {
+    if (job->remaining > 0)
+        return;
+
+    g_logger->log(LOG_DEBUG, "IPC: preloaded {}: {}", job->path, job->ok ? "ok" : "failed");
+
+    if (const auto MANAGER = job->manager.lock(); MANAGER)
+        MANAGER->sendPreloadDone(job->path.c_str(), job->ok ? 1 : 0);
+
+    std::erase(m_preloads, job);
+}
+
 void CSocket::onNewDisplay(const std::string& sv) {
     for (const auto& m : m_managers) {
         m->sendAddMonitor(sv.c_str());
@@ -2,9 +2,14 @@
 
 #include "../helpers/Memory.hpp"
 
+#include <string>
+#include <vector>
+
 #include <hyprwire/hyprwire.hpp>
 #include <hyprpaper_core-server.hpp>
 
+class CImageRequest;
+
 namespace IPC {
     class CWallpaperObject {
       public:
@@ -13,16 +18,37 @@ namespace IPC {
 
       private:
         void                          apply();
+        void                          applyFill();
 
         SP<CHyprpaperWallpaperObject> m_object;
 
         std::string                   m_path;
         hyprpaperCoreWallpaperFitMode m_fitMode = HYPRPAPER_CORE_WALLPAPER_FIT_MODE_COVER;
         std::string                   m_monitor;
+        std::string                   m_color, m_gradient;
 
         bool                          m_inert = false;
     };
 
+    class CTransactionObject {
+      public:
+        CTransactionObject(SP<CHyprpaperTransactionObject>&& obj);
+        ~CTransactionObject() = default;
+
+      private:
+        void commit();
+
+        struct SEntry {
+            std::string                   monitor, path;
+            hyprpaperCoreWallpaperFitMode fitMode = HYPRPAPER_CORE_WALLPAPER_FIT_MODE_COVER;
+        };
+
+        SP<CHyprpaperTransactionObject> m_object;
+        std::vector<SEntry>             m_entries;
+
+        bool                            m_inert = false;
+    };
+
     class CSocket {
       public:
         CSocket();
@@ -33,15 +59,30 @@ namespace IPC {
         void onWallpaperChanged(const std::string& mon, const std::string& path);
 
       private:
+        struct SPreload {
+            std::string                     path;
+            WP<CHyprpaperCoreManagerObject> manager;
+            size_t                          remaining = 0;
+            bool                            ok        = true;
+            std::vector<SP<CImageRequest>>  requests;
+        };
+
+        void                                         preload(SP<CHyprpaperCoreManagerObject> manager, const std::string& path, hyprpaperCoreWallpaperFitMode fitMode);
+        void                                         onPreloadProgress(SP<SPreload> job);
+
         SP<Hyprwire::IServerSocket>                  m_socket;
 
         std::string                                  m_socketPath = "";
 
         std::vector<SP<CHyprpaperCoreManagerObject>> m_managers;
         std::vector<SP<CWallpaperObject>>            m_wallpaperObjects;
+        std::vector<SP<CTransactionObject>>          m_transactionObjects;
         std::vector<SP<CHyprpaperStatusObject>>      m_statusObjects;
+        std::vector<SP<CHyprpaperStatsObject>>       m_statsObjects;
+        std::vector<SP<SPreload>>                    m_preloads;
 
         friend class CWallpaperObject;
+        friend class CTransactionObject;
     };
 
     inline UP<CSocket> g_IPCSocket;
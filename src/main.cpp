@@ -1,6 +1,7 @@
 #include "defines.hpp"
 #include "helpers/Logger.hpp"
 #include "helpers/GlobalState.hpp"
+#include "helpers/StartupProfiler.hpp"
 #include "ui/UI.hpp"
 #include "config/ConfigManager.hpp"
 
@@ -15,6 +16,8 @@ int main(int argc, const char** argv, const char** envp) {
     ASSERT(parser.registerStringOption("config", "c", "Set a custom config path"));
     ASSERT(parser.registerBoolOption("verbose", "", "Enable more logging"));
     ASSERT(parser.registerBoolOption("version", "v", "Show hyprpaper's version"));
+    ASSERT(parser.registerBoolOption("profile-startup", "", "Print where startup time goes, up to the first wallpaper on every output"));
+    ASSERT(parser.registerStringOption("profile-trace", "", "Like --profile-startup, also write a Chrome trace of it to a file"));
     ASSERT(parser.registerBoolOption("help", "h", "Show the help menu"));
 
     if (const auto ret = parser.parse(); !ret) {
@@ -37,11 +40,17 @@ int main(int argc, const char** argv, const char** envp) {
         g_state->verbose = true;
     }
 
+    if (const auto TRACE = parser.getString("profile-trace"); TRACE || parser.getBool("profile-startup").value_or(false))
+        g_profiler = makeUnique<CStartupProfiler>(std::string{TRACE.value_or("")});
+
     g_logger->log(LOG_DEBUG, "Welcome to hyprpaper!\nbuilt from commit {} ({})", GIT_COMMIT_HASH, GIT_COMMIT_MESSAGE);
 
     g_config = makeUnique<CConfigManager>(std::string{parser.getString("config").value_or("")});
-    if (!g_config->init())
-        return 1;
+    {
+        CScopedPhase phase("config");
+        if (!g_config->init())
+            return 1;
+    }
 
     g_ui = makeUnique<CUI>();
     g_ui->run();
@@ -0,0 +1,54 @@
+#include "FlipGroup.hpp"
+#include "UI.hpp"
+
+#include <algorithm>
+
+void CFlipGroup::join(CWallpaperTarget* target) {
+    m_members.emplace_back(SMember{.target = target});
+}
+
+void CFlipGroup::leave(CWallpaperTarget* target) {
+    std::erase_if(m_members, [target](const auto& e) { return e.target == target; });
+    flushIfReady();
+}
+
+void CFlipGroup::ready(CWallpaperTarget* target) {
+    const auto IT = std::ranges::find_if(m_members, [target](const auto& e) { return e.target == target; });
+
+    if (IT == m_members.end())
+        return;
+
+    IT->ready = true;
+    flushIfReady();
+}
+
+bool CFlipGroup::seal() {
+    m_sealed = true;
+    flushIfReady();
+    return m_flushed;
+}
+
+void CFlipGroup::flushIfReady() {
+    if (m_sealed && std::ranges::all_of(m_members, [](const auto& e) { return e.ready; }))
+        flush();
+}
+
+void CFlipGroup::flush() {
+    if (m_flushed)
+        return;
+
+    m_flushed = true;
+
+    if (m_timeout && !m_timeout->passed())
+        m_timeout->cancel();
+
+    m_timeout.reset();
+
+    // presenting drops the members' references to us, whoever called keeps us alive
+    auto members = std::move(m_members);
+    m_members.clear();
+
+    for (const auto& m : members) {
+        m.target->presentHeld();
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "../backend/Backend.hpp"
+#include "../helpers/Memory.hpp"
+
+class CWallpaperTarget;
+
+// Targets changed together hold their new image back until every one of them has it
+// decoded, then all present in the same dispatch, so the outputs flip together.
+class CFlipGroup {
+  public:
+    CFlipGroup()  = default;
+    ~CFlipGroup() = default;
+
+    CFlipGroup(const CFlipGroup&) = delete;
+    CFlipGroup(CFlipGroup&)       = delete;
+    CFlipGroup(CFlipGroup&&)      = delete;
+
+    void                     join(CWallpaperTarget* target);
+    // the target was destroyed or moved on before presenting
+    void                     leave(CWallpaperTarget* target);
+    void                     ready(CWallpaperTarget* target);
+
+    // no more members are coming. Returns true if everyone was ready and has presented.
+    bool                     seal();
+    // presents whatever is ready, used when someone takes too long
+    void                     flush();
+
+    SP<ITimer>               m_timeout;
+
+  private:
+    struct SMember {
+        CWallpaperTarget* target = nullptr;
+        bool              ready  = false;
+    };
+
+    void                 flushIfReady();
+
+    std::vector<SMember> m_members;
+    bool                 m_sealed = false, m_flushed = false;
+};
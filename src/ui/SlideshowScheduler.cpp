@@ -0,0 +1,143 @@
+#include "SlideshowScheduler.hpp"
+#include "../config/ConfigManager.hpp"
+#include "../helpers/Logger.hpp"
+#include "../helpers/Stats.hpp"
+
+#include <algorithm>
+
+CSlideshowScheduler::CSlideshowScheduler(SP<IBackend> backend) : m_backend(backend), m_epoch(backend->now()) {
+    ;
+}
+
+CSlideshowScheduler::~CSlideshowScheduler() {
+    if (m_timer && !m_timer->passed())
+        m_timer->cancel();
+}
+
+uint64_t CSlideshowScheduler::add(std::chrono::milliseconds period, std::chrono::milliseconds lead, std::function<void()>&& onTick, std::function<void()>&& onLead) {
+    static const auto PSYNC = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "slideshow_sync");
+
+    const auto        NOW = m_backend->now();
+    const auto        ID  = ++m_nextId;
+    SEntry            entry{.period = std::max(period, std::chrono::milliseconds{1}), .lead = lead, .onTick = std::move(onTick), .onLead = std::move(onLead)};
+
+    // synced slideshows tick on multiples of their period since startup, so equal periods line up
+    if (*PSYNC)
+        entry.deadline = m_epoch + ((NOW - m_epoch) / entry.period + 1) * entry.period;
+    else
+        entry.deadline = NOW + entry.period;
+
+    push(ID, entry);
+    m_entries.emplace(ID, std::move(entry));
+
+    arm();
+
+    return ID;
+}
+
+void CSlideshowScheduler::remove(uint64_t id) {
+    // queued events are dropped once they come up
+    m_entries.erase(id);
+}
+
+CSlideshowScheduler::Clock::time_point CSlideshowScheduler::deadline(uint64_t id) const {
+    const auto IT = m_entries.find(id);
+    return IT == m_entries.end() ? Clock::time_point::max() : IT->second.deadline;
+}
+
+CSlideshowScheduler::Clock::time_point CSlideshowScheduler::leadTime(uint64_t id) const {
+    const auto IT = m_entries.find(id);
+    return IT == m_entries.end() ? Clock::time_point::max() : IT->second.deadline - IT->second.lead;
+}
+
+void CSlideshowScheduler::push(uint64_t id, const SEntry& entry) {
+    m_queue.push(SEvent{.at = entry.deadline, .id = id, .lead = false});
+
+    if (entry.lead.count() > 0 && entry.lead < entry.period)
+        m_queue.push(SEvent{.at = entry.deadline - entry.lead, .id = id, .lead = true});
+}
+
+bool CSlideshowScheduler::valid(const SEvent& ev) const {
+    const auto IT = m_entries.find(ev.id);
+
+    if (IT == m_entries.end())
+        return false;
+
+    if (ev.lead)
+        return !IT->second.leadDone && ev.at == IT->second.deadline - IT->second.lead;
+
+    return ev.at == IT->second.deadline;
+}
+
+void CSlideshowScheduler::arm() {
+    while (!m_queue.empty() && !valid(m_queue.top())) {
+        m_queue.pop();
+    }
+
+    if (m_queue.empty())
+        return;
+
+    const auto AT = m_queue.top().at;
+
+    if (m_timer && !m_timer->passed()) {
+        if (m_timerAt <= AT)
+            return;
+
+        m_timer->cancel();
+    }
+
+    m_timerAt = AT;
+    m_timer   = m_backend->addTimer(std::max(AT - m_backend->now(), Clock::duration{0}), [this] { onTimer(); });
+}
+
+void CSlideshowScheduler::onTimer() {
+    static const auto PSLACK = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "timer_slack");
+
+    m_timer.reset();
+
+    const auto NOW     = m_backend->now();
+    const auto HORIZON = NOW + std::chrono::milliseconds(std::max(*PSLACK, Hyprlang::INT{0}));
+    size_t     fired   = 0;
+
+    // how far behind the deadline the timer woke us
+    g_stats->slideshow.timerLateUs.add(std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(NOW - m_timerAt).count(), 0));
+
+    while (!m_queue.empty() && m_queue.top().at <= HORIZON) {
+        const auto EV = m_queue.top();
+        m_queue.pop();
+
+        if (!valid(EV))
+            continue;
+
+        auto& entry = m_entries.at(EV.id);
+
+        // callbacks may remove or re-add entries, keep our own copy of what to run
+        std::function<void()> cb;
+
+        if (EV.lead) {
+            entry.leadDone = true;
+            cb             = entry.onLead;
+        } else {
+            // absolute deadlines, a late wakeup doesn't push the next one back. Ticks missed entirely are skipped.
+            do {
+                entry.deadline += entry.period;
+            } while (entry.deadline <= NOW);
+
+            entry.leadDone = false;
+            push(EV.id, entry);
+            cb = entry.onTick;
+
+            statsAdd(g_stats->slideshow.ticks);
+        }
+
+        fired++;
+
+        if (cb)
+            cb();
+    }
+
+    if (fired > 1)
+        g_logger->log(LOG_TRACE, "CSlideshowScheduler: {} events in one wakeup", fired);
+
+    arm();
+}
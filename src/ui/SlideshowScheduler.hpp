@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "../backend/Backend.hpp"
+#include "../helpers/Memory.hpp"
+
+// One timer for every slideshow. Deadlines are absolute and advance by whole periods,
+// so they don't drift however late a wakeup is. Everything due within timer_slack of
+// the earliest deadline is handled in the same wakeup, and with slideshow_sync, equal
+// periods share a phase, so monitors flip together.
+class CSlideshowScheduler {
+  public:
+    using Clock = IBackend::Clock;
+
+    CSlideshowScheduler(SP<IBackend> backend);
+    ~CSlideshowScheduler();
+
+    CSlideshowScheduler(const CSlideshowScheduler&) = delete;
+    CSlideshowScheduler(CSlideshowScheduler&)       = delete;
+    CSlideshowScheduler(CSlideshowScheduler&&)      = delete;
+
+    // onTick runs every period, onLead lead ahead of every tick (if lead is shorter than period)
+    uint64_t          add(std::chrono::milliseconds period, std::chrono::milliseconds lead, std::function<void()>&& onTick, std::function<void()>&& onLead);
+    void              remove(uint64_t id);
+
+    Clock::time_point deadline(uint64_t id) const;
+    Clock::time_point leadTime(uint64_t id) const;
+
+  private:
+    struct SEntry {
+        std::chrono::milliseconds period{0}, lead{0};
+        Clock::time_point         deadline;
+        bool                      leadDone = false;
+        std::function<void()>     onTick, onLead;
+    };
+
+    struct SEvent {
+        Clock::time_point at;
+        uint64_t          id   = 0;
+        bool              lead = false;
+
+        bool              operator>(const SEvent& other) const {
+            return at > other.at;
+        }
+    };
+
+    void                                                             push(uint64_t id, const SEntry& entry);
+    bool                                                             valid(const SEvent& ev) const;
+    void                                                             arm();
+    void                                                             onTimer();
+
+    SP<IBackend>                                                     m_backend;
+    Clock::time_point                                                m_epoch;
+    uint64_t                                                         m_nextId = 0;
+
+    std::unordered_map<uint64_t, SEntry>                             m_entries;
+    std::priority_queue<SEvent, std::vector<SEvent>, std::greater<>> m_queue;
+
+    SP<ITimer>                                                       m_timer;
+    Clock::time_point                                                m_timerAt;
+};
@@ -5,17 +5,32 @@
 #include "../ipc/HyprlandSocket.hpp"
 #include "../ipc/IPC.hpp"
 #include "../config/WallpaperMatcher.hpp"
+#include "../config/DirectoryWatcher.hpp"
+#include "../config/ConfigWatcher.hpp"
+#include "../image/ImageCache.hpp"
+#include "../image/DiskCache.hpp"
+#include "../helpers/Stats.hpp"
+#include "../helpers/StartupProfiler.hpp"
+#include "../backend/ToolkitBackend.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <random>
-#include <hyprtoolkit/core/Output.hpp>
 
 #include <hyprutils/string/String.hpp>
+#include <hyprutils/utils/ScopeGuard.hpp>
 
 CUI::CUI() = default;
 
 CUI::~CUI() {
+    m_splashRequest.reset();
+    g_configWatcher.reset();
+    g_directoryWatcher.reset();
     m_targets.clear();
+    m_scheduler.reset();
+    g_imageCache.reset();
+    g_decodePool.reset();
+    g_diskCache.reset();
 }
 
 static std::string_view pruneDesc(const std::string_view& sv) {
@@ -24,131 +39,658 @@ static std::string_view pruneDesc(const std::string_view& sv) {
     return sv;
 }
 
+static Hyprtoolkit::eImageFitMode toFitMode(const std::string_view& sv) {
+    if (sv.starts_with("contain"))
+        return Hyprtoolkit::IMAGE_FIT_MODE_CONTAIN;
+    if (sv.starts_with("cover"))
+        return Hyprtoolkit::IMAGE_FIT_MODE_COVER;
+    if (sv.starts_with("tile"))
+        return Hyprtoolkit::IMAGE_FIT_MODE_TILE;
+    if (sv.starts_with("fill"))
+        return Hyprtoolkit::IMAGE_FIT_MODE_STRETCH;
+    return Hyprtoolkit::IMAGE_FIT_MODE_COVER;
+}
+
+static CWallpaperTarget::eTransition toTransition(const std::string_view& sv) {
+    if (sv == "crossfade")
+        return CWallpaperTarget::TRANSITION_CROSSFADE;
+    if (sv == "slide")
+        return CWallpaperTarget::TRANSITION_SLIDE;
+    if (sv == "wipe")
+        return CWallpaperTarget::TRANSITION_WIPE;
+    return CWallpaperTarget::TRANSITION_NONE;
+}
+
+// a step per output frame
+static std::chrono::milliseconds frameInterval(const SP<IOutput>& output) {
+    const uint32_t FPS = output && output->fps() > 0 ? output->fps() : 60;
+    return std::chrono::milliseconds(std::max<uint32_t>(1000 / FPS, 1));
+}
+
+static float easeInOut(float t) {
+    return t * t * (3.F - 2.F * t);
+}
+
+constexpr const auto FLIP_TIMEOUT = std::chrono::milliseconds(2000);
+
+// a crossfade changes the incoming image's alpha at most this many times, whatever the refresh rate
+constexpr const float CROSSFADE_STEPS = 32.F;
+
+static uint64_t randomSeed() {
+    std::random_device rd;
+    return (sc<uint64_t>(rd()) << 32) | rd();
+}
+
 class CWallpaperTarget::CImagesData {
   public:
-    CImagesData(Hyprtoolkit::eImageFitMode fitMode, std::vector<std::string> images, const int timeout = 0, std::string order = "default") :
-        fitMode(fitMode), images(std::move(images)), order(std::move(order)), timeout(timeout > 0 ? timeout : 30) {}
-
-    const Hyprtoolkit::eImageFitMode fitMode;
-    std::vector<std::string>         images;
-    const std::string                order;
-    const int                        timeout;
-
-    std::string                      nextImage() {
-        if (order == "random-shuffle" && current + 1 >= images.size()) {
-            std::random_device rd;
-            std::mt19937       g(rd());
-            std::shuffle(images.begin(), images.end(), g);
-            current = 0;
-            return images[current];
+    CImagesData(SP<const CPlaylist> images, const int timeout = 0, std::string order = "default") :
+        images(std::move(images)), order(std::move(order)), timeout(timeout > 0 ? timeout : 30) {}
+
+    // shared with the matcher and other targets, only the cursor below is ours
+    SP<const CPlaylist> images;
+    const std::string   order;
+    const int           timeout;
+
+    // consumes the next image
+    std::string nextImage() {
+        if (m_upcoming.empty())
+            return advance();
+
+        auto next = std::move(m_upcoming.front());
+        m_upcoming.pop_front();
+        return next;
+    }
+
+    // peeks n images ahead without consuming anything, 0 being what nextImage() returns
+    const std::string& upcoming(size_t n) {
+        while (m_upcoming.size() <= n) {
+            m_upcoming.emplace_back(advance());
+        }
+
+        return m_upcoming[n];
+    }
+
+    // follows an updated playlist, continuing after whatever was queued last
+    void setImages(SP<const CPlaylist> newImages, const std::string& shown) {
+        const auto LAST = m_upcoming.empty() ? shown : m_upcoming.back();
+
+        images = std::move(newImages);
+
+        if (m_shuffle) {
+            m_shuffle.emplace(images->size(), randomSeed());
+            current = std::min(current, images->size() - 1);
+            return;
         }
 
-        current = (current + 1) % images.size();
-        return images[current];
+        current = images->find(LAST).value_or(std::min(current, images->size() - 1));
     }
 
   private:
-    size_t current = 0;
+    std::string advance() {
+        current = (current + 1) % images->size();
+
+        // every further pass walks a fresh permutation instead of reshuffling the list
+        if (order == "random-shuffle" && current == 0)
+            m_shuffle.emplace(images->size(), randomSeed());
+
+        return images->at(m_shuffle ? m_shuffle->at(current) : current);
+    }
+
+    size_t                           current = 0;
+    std::optional<CIndexPermutation> m_shuffle;
+    std::deque<std::string>          m_upcoming;
 };
 
-CWallpaperTarget::CWallpaperTarget(SP<Hyprtoolkit::IBackend> backend, SP<Hyprtoolkit::IOutput> output, const std::vector<std::string>& path, Hyprtoolkit::eImageFitMode fitMode,
-                                   const int timeout, const std::string& order) : m_monitorName(output->port()), m_backend(backend) {
-    static const auto SPLASH_REPLY = HyprlandSocket::getFromSocket("/splash");
+CWallpaperTarget::CWallpaperTarget(SP<IBackend> backend, SP<CSlideshowScheduler> scheduler, SP<IOutput> output, const CConfigManager::SSetting& setting, SP<CFlipGroup> flipGroup) :
+    m_monitorName(output->port()), m_output(output), m_scheduler(scheduler), m_backend(backend) {
+    m_window  = m_backend->createWindow(output);
+    m_resized = m_window->m_events.resized.listen([this] { onResized(); });
+
+    update(setting, flipGroup);
+}
 
-    static const auto PENABLESPLASH = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "splash");
+void CWallpaperTarget::setSplash(const std::string& text) {
     static const auto PSPLASHOFFSET = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "splash_offset");
     static const auto PSPLASHALPHA  = Hyprlang::CSimpleConfigValue<Hyprlang::FLOAT>(g_config->hyprlang(), "splash_opacity");
 
-    ASSERT(path.size() > 0);
+    if (m_splash)
+        return;
+
+    m_splash = true;
+    m_window->setSplash(text, sc<float>(*PSPLASHOFFSET), *PSPLASHALPHA);
+}
+
+CWallpaperTarget::~CWallpaperTarget() {
+    stopSlideshow();
+
+    if (const auto GROUP = std::move(m_flipGroup); GROUP)
+        GROUP->leave(this);
+
+    if (m_transition.timer && !m_transition.timer->passed())
+        m_transition.timer->cancel();
+}
+
+void CWallpaperTarget::update(const CConfigManager::SSetting& setting, SP<CFlipGroup> flipGroup) {
+    ASSERT(setting.fill || (setting.paths && !setting.paths->empty()));
 
-    m_window = Hyprtoolkit::CWindowBuilder::begin()
-                   ->type(Hyprtoolkit::HT_WINDOW_LAYER)
-                   ->prefferedOutput(output)
-                   ->anchor(0xF)
-                   ->layer(0)
-                   ->preferredSize({0, 0})
-                   ->exclusiveZone(-1)
-                   ->appClass("hyprpaper")
-                   ->commence();
+    // forget the previous setting's slideshow. Whatever is on screen stays there until the new image is ready.
+    stopSlideshow();
 
-    m_bg = Hyprtoolkit::CRectangleBuilder::begin()
-               ->size({Hyprtoolkit::CDynamicSize::HT_SIZE_PERCENT, Hyprtoolkit::CDynamicSize::HT_SIZE_PERCENT, {1, 1}})
-               ->color([] { return Hyprtoolkit::CHyprColor{0xFF000000}; })
-               ->commence();
-    m_null = Hyprtoolkit::CNullBuilder::begin()->size({Hyprtoolkit::CDynamicSize::HT_SIZE_PERCENT, Hyprtoolkit::CDynamicSize::HT_SIZE_PERCENT, {1, 1}})->commence();
+    if (const auto GROUP = std::move(m_flipGroup); GROUP)
+        GROUP->leave(this);
 
-    m_image = Hyprtoolkit::CImageBuilder::begin()
-                  ->path(std::string{path.front()})
-                  ->size({Hyprtoolkit::CDynamicSize::HT_SIZE_PERCENT, Hyprtoolkit::CDynamicSize::HT_SIZE_PERCENT, {1.F, 1.F}})
-                  ->sync(true)
-                  ->fitMode(fitMode)
-                  ->commence();
+    m_heldImage.reset();
 
-    m_lastPath = path.front();
+    m_prefetch.clear();
+    m_currentJob.reset();
+    m_resizeJob.reset();
+    m_imagesData.reset();
+    m_swapPending = false;
 
-    m_image->setPositionMode(Hyprtoolkit::IElement::HT_POSITION_ABSOLUTE);
-    m_image->setPositionFlag(Hyprtoolkit::IElement::HT_POSITION_FLAG_CENTER, true);
+    // the output may have changed mode since the last setting
+    if (const auto OUTPUT = m_output.lock(); OUTPUT)
+        m_outputSize = OUTPUT->pixelSize();
 
-    if (path.size() > 1) {
-        m_imagesData = makeUnique<CImagesData>(fitMode, std::vector<std::string>(path), timeout, order);
-        m_timer =
-            m_backend->addTimer(std::chrono::milliseconds(std::chrono::seconds(m_imagesData->timeout)), [this](ASP<Hyprtoolkit::CTimer> self, void*) { onRepeatTimer(); }, nullptr);
+    m_settingId          = setting.id;
+    m_fitMode            = toFitMode(setting.fitMode);
+    m_prefetchDepth      = std::max(setting.prefetch, 1);
+    m_prefetchTime       = std::max(setting.prefetchTime, 0);
+    m_transitionType     = toTransition(setting.transition);
+    m_transitionDuration = std::chrono::milliseconds(std::max(setting.transitionDuration, 0));
+
+    m_fill = setting.fill;
+
+    // nothing to wait for, so no flip group either
+    if (m_fill) {
+        showFill(*m_fill);
+        return;
     }
 
-    m_window->m_rootElement->addChild(m_bg);
-    m_window->m_rootElement->addChild(m_null);
-    m_null->addChild(m_image);
+    m_lastPath = setting.paths->at(0);
 
-    if (!SPLASH_REPLY)
-        g_logger->log(LOG_ERR, "Can't get splash: {}", SPLASH_REPLY.error());
+    if (setting.paths->size() > 1) {
+        m_imagesData = makeUnique<CImagesData>(setting.paths, setting.timeout, setting.order);
+        startSlideshow();
+    }
 
-    if (SPLASH_REPLY && *PENABLESPLASH) {
-        m_splash = Hyprtoolkit::CTextBuilder::begin()
-                       ->text(std::string{SPLASH_REPLY.value()})
-                       ->fontSize({Hyprtoolkit::CFontSize::HT_FONT_TEXT, 1.15F})
-                       ->color([] { return g_ui->backend()->getPalette()->m_colors.text; })
-                       ->a(*PSPLASHALPHA)
-                       ->commence();
-        m_splash->setPositionMode(Hyprtoolkit::IElement::HT_POSITION_ABSOLUTE);
-        m_splash->setPositionFlag(Hyprtoolkit::IElement::HT_POSITION_FLAG_HCENTER, true);
-        m_splash->setPositionFlag(Hyprtoolkit::IElement::HT_POSITION_FLAG_BOTTOM, true);
-        m_splash->setAbsolutePosition({0.F, sc<float>(-*PSPLASHOFFSET)});
-        m_null->addChild(m_splash);
+    if (flipGroup) {
+        m_flipGroup = flipGroup;
+        m_flipGroup->join(this);
     }
 
-    m_window->open();
+    // decode off the main thread, the background stays up until the first image is ready
+    const auto KEY = g_imageCache->keyFor(m_lastPath, m_outputSize, m_fitMode);
+
+    if (const auto IMAGE = g_imageCache->get(KEY))
+        onFirstImageReady(IMAGE);
+    else {
+        m_currentJob = g_imageCache->load(KEY, [this](SP<CDecodedImage> image) {
+            m_currentJob.reset();
+            onFirstImageReady(image);
+        });
+    }
 }
 
-CWallpaperTarget::~CWallpaperTarget() {
-    if (m_timer && !m_timer->passed())
-        m_timer->cancel();
+void CWallpaperTarget::updatePlaylist(const CConfigManager::SSetting& setting) {
+    if (m_imagesData) {
+        m_imagesData->setImages(setting.paths, m_lastPath);
+        return;
+    }
+
+    if (setting.paths->size() <= 1)
+        return;
+
+    // was a single image so far, start the slideshow from what's on screen
+    m_imagesData = makeUnique<CImagesData>(setting.paths, setting.timeout, setting.order);
+    m_imagesData->setImages(setting.paths, m_lastPath);
+
+    startSlideshow();
+
+    if (m_currentImage)
+        schedulePrefetch();
 }
 
-void CWallpaperTarget::onRepeatTimer() {
+void CWallpaperTarget::presentHeld() {
+    m_flipGroup.reset();
 
-    ASSERT(m_imagesData);
+    // not decoded yet if the group timed out, it'll show up on its own then
+    if (const auto IMAGE = std::move(m_heldImage); IMAGE)
+        onFirstImageReady(IMAGE);
+}
 
-    m_lastPath = m_imagesData->nextImage();
+void CWallpaperTarget::onFirstImageReady(const SP<CDecodedImage>& image) {
+    if (m_flipGroup) {
+        m_heldImage = image;
 
-    m_image->rebuild()
-        ->path(std::string{m_lastPath})
-        ->size({Hyprtoolkit::CDynamicSize::HT_SIZE_PERCENT, Hyprtoolkit::CDynamicSize::HT_SIZE_PERCENT, {1.F, 1.F}})
-        ->sync(true)
-        ->fitMode(m_imagesData->fitMode)
-        ->commence();
+        // may present right away, if we were the last one
+        const auto GROUP = m_flipGroup;
+        GROUP->ready(this);
+        return;
+    }
+
+    if (g_profiler && m_frameStats.presents == 0)
+        g_profiler->outputReady(m_monitorName, !!image);
+
+    if (!image)
+        return;
 
-    m_timer =
-        m_backend->addTimer(std::chrono::milliseconds(std::chrono::seconds(m_imagesData->timeout)), [this](ASP<Hyprtoolkit::CTimer> self, void*) { onRepeatTimer(); }, nullptr);
+    // a color may have been showing, letterboxing is black
+    setBackground(0xFF000000);
+    showImage(image);
 
     if (IPC::g_IPCSocket)
         IPC::g_IPCSocket->onWallpaperChanged(m_monitorName, m_lastPath);
+
+    if (m_imagesData)
+        schedulePrefetch();
 }
 
-void CUI::registerOutput(const SP<Hyprtoolkit::IOutput>& mon) {
+void CWallpaperTarget::showImage(const SP<CDecodedImage>& image) {
+    const auto                    BEGIN = std::chrono::steady_clock::now();
+    Hyprutils::Utils::CScopeGuard x([BEGIN] {
+        g_stats->present.presentUs.add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - BEGIN).count());
+    });
+
+    auto outgoing  = std::move(m_currentImage);
+    m_currentImage = image;
+    m_lastPath     = image->path();
+
+    m_frameStats.presents++;
+
+    if (!m_image) {
+        m_image = m_window->addImage(image, m_fitMode, 1.F);
+        return;
+    }
+
+    if (m_transitionType != TRANSITION_NONE && m_transitionDuration.count() > 0 && outgoing) {
+        startTransition(std::move(outgoing));
+        return;
+    }
+
+    endTransition();
+
+    m_image->setImage(image, m_fitMode);
+}
+
+void CWallpaperTarget::showFill(const CConfigManager::SFill& fill) {
+    const bool FIRST = m_frameStats.presents == 0;
+
+    m_fitMode = Hyprtoolkit::IMAGE_FIT_MODE_STRETCH;
+
+    setBackground(fill.colors.at(0));
+
+    if (fill.colors.size() > 1) {
+        // the rectangle can't do gradients, a tiny stretched image can
+        auto image = CDecodedImage::gradient(fill.describe(), fill.colors, fill.angle, m_outputSize);
+
+        if (!image) {
+            g_logger->log(LOG_ERR, "{}: failed to draw a gradient: {}", m_monitorName, image.error());
+
+            if (g_profiler && FIRST)
+                g_profiler->outputReady(m_monitorName, false);
+            return;
+        }
+
+        showImage(*image);
+    } else {
+        // the background is all there is, no buffer at all
+        endTransition();
+
+        if (m_image)
+            m_window->removeImage(m_image);
+
+        m_image.reset();
+        m_currentImage.reset();
+        m_lastPath = fill.describe();
+
+        m_frameStats.presents++;
+    }
+
+    if (g_profiler && FIRST)
+        g_profiler->outputReady(m_monitorName, true);
+
+    if (IPC::g_IPCSocket)
+        IPC::g_IPCSocket->onWallpaperChanged(m_monitorName, m_lastPath);
+}
+
+void CWallpaperTarget::setBackground(uint32_t color) {
+    if (m_bgColor == color)
+        return;
+
+    m_bgColor = color;
+    m_window->setBackground(color);
+}
+
+size_t CWallpaperTarget::residentBytes() const {
+    size_t bytes = 0;
+
+    for (const auto& img : {m_currentImage, m_heldImage, m_transition.image}) {
+        if (img)
+            bytes += img->bytes();
+    }
+
+    for (const auto& p : m_prefetch) {
+        if (p.image)
+            bytes += p.image->bytes();
+    }
+
+    return bytes;
+}
+
+void CWallpaperTarget::startTransition(SP<CDecodedImage> outgoing) {
+    // a transition still running is cut short, only two images are ever on screen
+    endTransition();
+
+    // the outgoing layer keeps the surface it already has, nothing is decoded again
+    m_transition.type  = m_transitionType;
+    m_transition.layer = m_image;
+    m_transition.image = std::move(outgoing);
+    m_transition.start = m_backend->now();
+    m_transition.alpha = m_transition.type == TRANSITION_CROSSFADE ? 0.F : 1.F;
+
+    // added last, so it's drawn above the outgoing one
+    m_image = m_window->addImage(m_currentImage, m_fitMode, m_transition.alpha);
+
+    if (m_transition.type != TRANSITION_CROSSFADE)
+        m_image->setPosition({logicalSize().x, 0.F});
+
+    m_transition.timer = m_backend->addTimer(frameInterval(m_output.lock()), [this] { onTransitionFrame(); });
+}
+
+void CWallpaperTarget::onTransitionFrame() {
+    m_transition.timer.reset();
+    m_frameStats.wakeups++;
+
+    // frames are only ever requested while something moves
+    if (!m_transition.layer)
+        return;
+
+    const auto ELAPSED = std::chrono::duration_cast<std::chrono::milliseconds>(m_backend->now() - m_transition.start);
+
+    if (ELAPSED >= m_transitionDuration) {
+        endTransition();
+        return;
+    }
+
+    const float PROGRESS = sc<float>(ELAPSED.count()) / sc<float>(m_transitionDuration.count());
+    const float WIDTH    = logicalSize().x;
+
+    switch (m_transition.type) {
+        case TRANSITION_CROSSFADE: {
+            const float ALPHA = std::floor(PROGRESS * CROSSFADE_STEPS) / CROSSFADE_STEPS;
+            if (ALPHA != m_transition.alpha) {
+                m_transition.alpha = ALPHA;
+                m_image->setAlpha(ALPHA);
+            }
+            break;
+        }
+        case TRANSITION_SLIDE:
+            m_image->setPosition({WIDTH * (1.F - easeInOut(PROGRESS)), 0.F});
+            m_transition.layer->setPosition({-WIDTH * easeInOut(PROGRESS), 0.F});
+            break;
+        // the incoming image is pulled over the outgoing one, which stays put
+        case TRANSITION_WIPE: m_image->setPosition({WIDTH * (1.F - easeInOut(PROGRESS)), 0.F}); break;
+        default: break;
+    }
+
+    m_frameStats.transitionFrames++;
+
+    m_transition.timer = m_backend->addTimer(frameInterval(m_output.lock()), [this] { onTransitionFrame(); });
+}
+
+void CWallpaperTarget::endTransition() {
+    if (!m_transition.layer)
+        return;
+
+    if (m_transition.timer && !m_transition.timer->passed())
+        m_transition.timer->cancel();
+
+    if (m_transition.type == TRANSITION_CROSSFADE)
+        m_image->setAlpha(1.F);
+    else
+        m_image->setPosition({0.F, 0.F});
+
+    // drop the outgoing buffer right away, the cache decides whether it sticks around
+    m_window->removeImage(m_transition.layer);
+    m_transition = {};
+
+    g_logger->log(LOG_TRACE, "{}: transition done, idle", m_monitorName);
+}
+
+void CWallpaperTarget::onResized() {
+    const auto OUTPUT = m_output.lock();
+
+    if (!OUTPUT || OUTPUT->pixelSize() == m_outputSize)
+        return;
+
+    m_outputSize = OUTPUT->pixelSize();
+
+    g_logger->log(LOG_DEBUG, "{}: output is {}x{} now, decoding for that", m_monitorName, m_outputSize.x, m_outputSize.y);
+
+    // all decoded for the old size
+    m_prefetch.clear();
+    m_resizeJob.reset();
+
+    if (m_fill) {
+        if (m_fill->colors.size() <= 1)
+            return;
+
+        if (auto image = CDecodedImage::gradient(m_fill->describe(), m_fill->colors, m_fill->angle, m_outputSize); image)
+            replaceImage(*image);
+        else
+            g_logger->log(LOG_ERR, "{}: failed to draw a gradient: {}", m_monitorName, image.error());
+
+        return;
+    }
+
+    // the first image isn't up yet, ask for it at the new size instead
+    if (m_currentJob) {
+        m_currentJob = g_imageCache->load(g_imageCache->keyFor(m_lastPath, m_outputSize, m_fitMode), [this](SP<CDecodedImage> image) {
+            m_currentJob.reset();
+            onFirstImageReady(image);
+        });
+        return;
+    }
+
+    if (m_currentImage) {
+        const auto KEY = g_imageCache->keyFor(m_currentImage->path(), m_outputSize, m_fitMode);
+
+        if (const auto IMAGE = g_imageCache->get(KEY))
+            replaceImage(IMAGE);
+        else {
+            m_resizeJob = g_imageCache->load(KEY, [this](SP<CDecodedImage> image) {
+                m_resizeJob.reset();
+
+                // the slideshow may have moved on meanwhile
+                if (image && m_currentImage && image->path() == m_currentImage->path())
+                    replaceImage(image);
+            });
+        }
+    }
+
+    if (!m_imagesData || !m_currentImage)
+        return;
+
+    // a late swap waits on the first slot, which is gone now
+    if (m_swapPending)
+        prefetch();
+    else
+        schedulePrefetch();
+}
+
+void CWallpaperTarget::replaceImage(const SP<CDecodedImage>& image) {
+    endTransition();
+
+    m_currentImage = image;
+    m_frameStats.presents++;
+
+    if (m_image)
+        m_image->setImage(image, m_fitMode);
+    else
+        m_image = m_window->addImage(image, m_fitMode, 1.F);
+}
+
+Hyprutils::Math::Vector2D CWallpaperTarget::logicalSize() {
+    const float SCALE = m_window->scale();
+    return SCALE > 0.F ? m_outputSize / SCALE : m_outputSize;
+}
+
+void CWallpaperTarget::startSlideshow() {
+    stopSlideshow();
+
+    const auto SCHEDULER = m_scheduler.lock();
+    if (!SCHEDULER)
+        return;
+
+    m_slideshowId = SCHEDULER->add(
+        std::chrono::seconds(m_imagesData->timeout), std::chrono::seconds(m_prefetchTime), [this] { onRepeatTimer(); },
+        [this] {
+            m_frameStats.wakeups++;
+
+            // nothing to prefetch before the first image is up
+            if (m_currentImage)
+                prefetch();
+        });
+}
+
+void CWallpaperTarget::stopSlideshow() {
+    if (m_slideshowId == 0)
+        return;
+
+    if (const auto SCHEDULER = m_scheduler.lock(); SCHEDULER)
+        SCHEDULER->remove(m_slideshowId);
+
+    m_slideshowId = 0;
+}
+
+void CWallpaperTarget::schedulePrefetch() {
+    const auto SCHEDULER = m_scheduler.lock();
+
+    // the scheduler runs prefetch() ahead of every tick, unless that moment is already gone
+    if (!SCHEDULER || m_slideshowId == 0 || SCHEDULER->leadTime(m_slideshowId) <= m_backend->now())
+        prefetch();
+}
+
+void CWallpaperTarget::prefetch() {
+    static const auto PPREFETCHSIZE = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "prefetch_size");
+
+    const size_t      BUDGET = sc<size_t>(std::max(*PPREFETCHSIZE, Hyprlang::INT{0})) * 1024 * 1024;
+    size_t            held   = 0;
+
+    for (size_t i = 0; i < m_prefetchDepth; ++i) {
+        if (i >= m_prefetch.size())
+            m_prefetch.emplace_back(SPrefetch{.id = ++m_prefetchSeq});
+
+        const auto& SLOT = m_prefetch[i];
+
+        if (SLOT.image) {
+            held += SLOT.image->bytes();
+            continue;
+        }
+
+        if (SLOT.request || SLOT.failed)
+            continue;
+
+        // the very next image is always fetched, anything past it has to fit the budget
+        if (i > 0 && held >= BUDGET)
+            break;
+
+        requestPrefetch(i);
+    }
+}
+
+void CWallpaperTarget::requestPrefetch(size_t idx) {
+    const auto KEY  = g_imageCache->keyFor(m_imagesData->upcoming(idx), m_outputSize, m_fitMode);
+    auto&      slot = m_prefetch[idx];
+
+    // another output may have it resident already
+    slot.image = g_imageCache->get(KEY);
+
+    if (!slot.image)
+        slot.request = g_imageCache->load(KEY, [this, id = slot.id](SP<CDecodedImage> image) { onPrefetched(id, std::move(image)); });
+}
+
+void CWallpaperTarget::onPrefetched(uint64_t id, SP<CDecodedImage> image) {
+    const auto IT = std::ranges::find_if(m_prefetch, [id](const auto& e) { return e.id == id; });
+
+    if (IT == m_prefetch.end())
+        return;
+
+    IT->request.reset();
+    IT->image  = std::move(image);
+    IT->failed = !IT->image;
+
+    if (m_swapPending && IT == m_prefetch.begin()) {
+        if (IT->failed)
+            advance();
+        else
+            swapToNextImage();
+    }
+}
+
+void CWallpaperTarget::swapToNextImage() {
+    if (m_swapPending) {
+        const auto LATEUS = std::chrono::duration_cast<std::chrono::microseconds>(m_backend->now() - m_swapDeadline).count();
+        statsMax(g_stats->slideshow.lateMaxUs, LATEUS);
+        g_logger->log(LOG_TRACE, "{}: wallpaper swap was late by {}ms", m_monitorName, LATEUS / 1000);
+    }
+
+    m_swapPending = false;
+    statsAdd(g_stats->slideshow.swaps);
+
+    auto image = std::move(m_prefetch.front().image);
+    m_prefetch.pop_front();
+    m_imagesData->nextImage();
+
+    showImage(image);
+
+    if (IPC::g_IPCSocket)
+        IPC::g_IPCSocket->onWallpaperChanged(m_monitorName, m_lastPath);
+
+    schedulePrefetch();
+}
+
+void CWallpaperTarget::onRepeatTimer() {
+
+    ASSERT(m_imagesData);
+
+    m_frameStats.wakeups++;
+
+    advance();
+}
+
+void CWallpaperTarget::advance() {
+    // skip over images which failed to decode
+    for (size_t i = 0; i < m_imagesData->images->size() && !m_prefetch.empty() && m_prefetch.front().failed; ++i) {
+        m_prefetch.pop_front();
+        m_imagesData->nextImage();
+    }
+
+    if (m_prefetch.empty())
+        m_prefetch.emplace_back(SPrefetch{.id = ++m_prefetchSeq});
+
+    if (!m_prefetch.front().image && !m_prefetch.front().request)
+        requestPrefetch(0);
+
+    if (m_prefetch.front().image) {
+        swapToNextImage();
+        return;
+    }
+
+    if (m_swapPending)
+        return;
+
+    // the next image isn't decoded yet: keep the current one on screen and swap once it's ready
+    m_swapPending  = true;
+    m_swapDeadline = m_backend->now();
+    statsAdd(g_stats->slideshow.lateSwaps);
+}
+
+void CUI::registerOutput(const SP<IOutput>& mon) {
     g_matcher->registerOutput(mon->port(), pruneDesc(mon->desc()));
     if (IPC::g_IPCSocket)
         IPC::g_IPCSocket->onNewDisplay(mon->port());
-    mon->m_events.removed.listenStatic([this, m = WP<Hyprtoolkit::IOutput>{mon}] {
+    mon->m_events.removed.listenStatic([this, m = WP<IOutput>{mon}] {
         g_matcher->unregisterOutput(m->port());
         if (IPC::g_IPCSocket)
             IPC::g_IPCSocket->onRemovedDisplay(m->port());
@@ -156,64 +698,114 @@ void CUI::registerOutput(const SP<Hyprtoolkit::IOutput>& mon) {
     });
 }
 
-bool CUI::run() {
-    static const auto PENABLEIPC = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "ipc");
-
-    //
-    Hyprtoolkit::IBackend::SBackendCreationData data;
-    data.pLogConnection = makeShared<Hyprutils::CLI::CLoggerConnection>(*g_logger);
-    data.pLogConnection->setName("hyprtoolkit");
-    data.pLogConnection->setLogLevel(g_state->verbose ? LOG_TRACE : LOG_ERR);
-
-    m_backend = Hyprtoolkit::IBackend::createWithData(data);
+bool CUI::init(SP<IBackend> backend) {
+    static const auto PENABLESPLASH  = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "splash");
+    static const auto PENABLEIPC     = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "ipc");
+    static const auto PCACHESIZE     = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "cache_size");
+    static const auto PDISKCACHE     = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "disk_cache");
+    static const auto PDISKCACHESIZE = Hyprlang::CSimpleConfigValue<Hyprlang::INT>(g_config->hyprlang(), "disk_cache_size");
+
+    if (backend)
+        m_backend = backend;
+    else {
+        CScopedPhase phase("create backend");
+        m_backend = CToolkitBackend::create();
+    }
 
     if (!m_backend)
         return false;
 
+    g_config->setBackend(m_backend);
+
+    if (*PDISKCACHE) {
+        if (const auto DIR = CDiskCache::defaultDir(); DIR)
+            g_diskCache = makeUnique<CDiskCache>(*DIR, sc<size_t>(std::max(*PDISKCACHESIZE, Hyprlang::INT{0})) * 1024 * 1024);
+        else
+            g_logger->log(LOG_WARN, "disk_cache is enabled, but there is no cache directory (no $XDG_CACHE_HOME or $HOME)");
+    }
+
+    m_scheduler        = makeShared<CSlideshowScheduler>(m_backend);
+    g_decodePool       = makeUnique<CDecodePool>(m_backend);
+    g_imageCache       = makeUnique<CImageCache>(sc<size_t>(std::max(*PCACHESIZE, Hyprlang::INT{0})) * 1024 * 1024);
+    g_directoryWatcher = makeUnique<CDirectoryWatcher>(m_backend);
+    g_configWatcher    = makeUnique<CConfigWatcher>(m_backend);
+
     if (*PENABLEIPC)
         IPC::g_IPCSocket = makeUnique<IPC::CSocket>();
 
-    const auto MONITORS = m_backend->getOutputs();
+    // wallpapers don't wait for this, the splash is added whenever it arrives
+    if (*PENABLESPLASH) {
+        m_splashRequest = HyprlandSocket::getFromSocket(m_backend, "/splash", [this, begin = std::chrono::steady_clock::now()](HyprlandSocket::Reply reply) {
+            m_splashRequest.reset();
+
+            if (g_profiler)
+                g_profiler->add("splash", reply ? "" : reply.error(), begin, std::chrono::steady_clock::now());
+
+            if (!reply) {
+                g_logger->log(LOG_ERR, "Can't get splash: {}", reply.error());
+                return;
+            }
+
+            m_splash = std::move(*reply);
+
+            for (const auto& t : m_targets) {
+                t->setSplash(*m_splash);
+            }
+        });
+    }
+
+    const auto MONITORS = [this] {
+        CScopedPhase phase("enumerate outputs");
+        return m_backend->getOutputs();
+    }();
 
     for (const auto& m : MONITORS) {
         registerOutput(m);
     }
 
-    m_listeners.newMon = m_backend->m_events.outputAdded.listen([this](SP<Hyprtoolkit::IOutput> mon) { registerOutput(mon); });
+    m_listeners.newMon = m_backend->m_events.outputAdded.listen([this](SP<IOutput> mon) { registerOutput(mon); });
 
     g_logger->log(LOG_DEBUG, "Found {} output(s)", MONITORS.size());
 
     // load the config now, then bind
-    for (const auto& m : MONITORS) {
-        targetChanged(m);
+    {
+        CScopedPhase phase("create targets");
+
+        for (const auto& m : MONITORS) {
+            targetChanged(m);
+        }
     }
 
-    m_listeners.targetChanged = g_matcher->m_events.monitorConfigChanged.listen([this](const std::string_view& m) { targetChanged(m); });
+    if (g_profiler)
+        g_profiler->expectOutputs(m_targets.size());
 
-    m_backend->enterLoop();
+    m_listeners.targetChanged   = g_matcher->m_events.monitorConfigChanged.listen([this](const std::string_view& m) { targetChanged(m); });
+    m_listeners.playlistChanged = g_matcher->m_events.playlistChanged.listen([this](const CConfigManager::SSetting& s) {
+        for (const auto& t : m_targets) {
+            if (t->m_settingId == s.id)
+                t->updatePlaylist(s);
+        }
+    });
 
     return true;
 }
 
-SP<Hyprtoolkit::IBackend> CUI::backend() {
-    return m_backend;
+bool CUI::run() {
+    if (!init())
+        return false;
+
+    m_backend->enterLoop();
+
+    return true;
 }
 
-static Hyprtoolkit::eImageFitMode toFitMode(const std::string_view& sv) {
-    if (sv.starts_with("contain"))
-        return Hyprtoolkit::IMAGE_FIT_MODE_CONTAIN;
-    if (sv.starts_with("cover"))
-        return Hyprtoolkit::IMAGE_FIT_MODE_COVER;
-    if (sv.starts_with("tile"))
-        return Hyprtoolkit::IMAGE_FIT_MODE_TILE;
-    if (sv.starts_with("fill"))
-        return Hyprtoolkit::IMAGE_FIT_MODE_STRETCH;
-    return Hyprtoolkit::IMAGE_FIT_MODE_COVER;
+SP<IBackend> CUI::backend() {
+    return m_backend;
 }
 
 void CUI::targetChanged(const std::string_view& monName) {
-    const auto               MONITORS = m_backend->getOutputs();
-    SP<Hyprtoolkit::IOutput> monitor;
+    const auto  MONITORS = m_backend->getOutputs();
+    SP<IOutput> monitor;
 
     for (const auto& m : MONITORS) {
         if (m->port() != monName)
@@ -230,17 +822,47 @@ void CUI::targetChanged(const std::string_view& monName) {
     targetChanged(monitor);
 }
 
-void CUI::targetChanged(const SP<Hyprtoolkit::IOutput>& mon) {
+void CUI::targetChanged(const SP<IOutput>& mon) {
     const auto TARGET = g_matcher->getSetting(mon->port(), pruneDesc(mon->desc()));
 
     if (!TARGET) {
         g_logger->log(LOG_DEBUG, "Monitor {} has no target: no wp will be created", mon->port());
+        std::erase_if(m_targets, [&mon](const auto& e) { return e->m_monitorName == mon->port(); });
+        return;
+    }
+
+    const auto EXISTING = std::ranges::find_if(m_targets, [&mon](const auto& e) { return e->m_monitorName == mon->port(); });
+
+    // same output, keep the window and only change what it shows
+    if (EXISTING != m_targets.end() && (*EXISTING)->m_output.lock() == mon) {
+        (*EXISTING)->update(TARGET->get(), m_flipGroup);
         return;
     }
 
     std::erase_if(m_targets, [&mon](const auto& e) { return e->m_monitorName == mon->port(); });
 
-    m_targets.emplace_back(makeShared<CWallpaperTarget>(m_backend, mon, TARGET->get().paths, toFitMode(TARGET->get().fitMode), TARGET->get().timeout, TARGET->get().order));
+    const auto NEWTARGET = m_targets.emplace_back(makeShared<CWallpaperTarget>(m_backend, m_scheduler, mon, TARGET->get(), m_flipGroup));
+
+    if (m_splash)
+        NEWTARGET->setSplash(*m_splash);
+}
+
+void CUI::flipTogether(const std::function<void()>& fn) {
+    auto group  = makeShared<CFlipGroup>();
+    m_flipGroup = group;
+
+    fn();
+
+    m_flipGroup.reset();
+
+    if (group->seal())
+        return;
+
+    // one slow decode shouldn't keep every other output waiting
+    group->m_timeout = m_backend->addTimer(FLIP_TIMEOUT, [weak = WP<CFlipGroup>{group}] {
+        if (const auto GROUP = weak.lock(); GROUP)
+            GROUP->flush();
+    });
 }
 
 const std::vector<SP<CWallpaperTarget>>& CUI::targets() {
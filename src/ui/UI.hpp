@@ -1,44 +1,136 @@
 #pragma once
 
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
 #include <vector>
 
-#include <hyprtoolkit/core/Backend.hpp>
-#include <hyprtoolkit/core/Timer.hpp>
-#include <hyprtoolkit/window/Window.hpp>
-#include <hyprtoolkit/element/Text.hpp>
-#include <hyprtoolkit/element/Null.hpp>
-#include <hyprtoolkit/element/Image.hpp>
-#include <hyprtoolkit/element/Rectangle.hpp>
-
 #include <hyprutils/signal/Listener.hpp>
 
 #include "../helpers/Memory.hpp"
+#include "../backend/Backend.hpp"
+#include "../config/ConfigManager.hpp"
+#include "SlideshowScheduler.hpp"
+#include "FlipGroup.hpp"
+#include "../ipc/HyprlandSocket.hpp"
+
+class CDecodedImage;
+class CImageRequest;
 
 class CWallpaperTarget {
   public:
-    CWallpaperTarget(SP<Hyprtoolkit::IBackend> backend, SP<Hyprtoolkit::IOutput> output, const std::vector<std::string>& path,
-                     Hyprtoolkit::eImageFitMode fitMode = Hyprtoolkit::IMAGE_FIT_MODE_COVER, const int timeout = 0, const std::string& order = "default");
+    enum eTransition : uint8_t {
+        TRANSITION_NONE = 0,
+        TRANSITION_CROSSFADE,
+        TRANSITION_SLIDE,
+        TRANSITION_WIPE,
+    };
+
+    CWallpaperTarget(SP<IBackend> backend, SP<CSlideshowScheduler> scheduler, SP<IOutput> output, const CConfigManager::SSetting& setting, SP<CFlipGroup> flipGroup = nullptr);
     ~CWallpaperTarget();
 
     CWallpaperTarget(const CWallpaperTarget&) = delete;
     CWallpaperTarget(CWallpaperTarget&)       = delete;
     CWallpaperTarget(CWallpaperTarget&&)      = delete;
 
-    std::string m_monitorName, m_lastPath;
+    // switches to another setting in place, keeping the window. With a flip group, the new
+    // image is held back until the whole group is ready.
+    void                     update(const CConfigManager::SSetting& setting, SP<CFlipGroup> flipGroup = nullptr);
+    void                     updatePlaylist(const CConfigManager::SSetting& setting);
+    void                     presentHeld();
+    void                     setSplash(const std::string& text);
+
+    // decoded images this target holds on to. Images shared with other targets count for each.
+    size_t                   residentBytes() const;
+
+    std::string              m_monitorName, m_lastPath;
+    WP<IOutput>              m_output;
+    uint32_t                 m_settingId = 0;
+
+    // Everything this target made the compositor redraw. Once an image is up nothing is
+    // requested until the next timer or IPC event, so only wakeups move while idle.
+    struct SFrameStats {
+        uint64_t presents         = 0; // image changes
+        uint64_t transitionFrames = 0;
+        uint64_t wakeups          = 0; // timer callbacks, drawing or not
+    } m_frameStats;
 
   private:
+    void startSlideshow();
+    void stopSlideshow();
     void onRepeatTimer();
+    void advance();
+    void onFirstImageReady(const SP<CDecodedImage>& image);
+    void schedulePrefetch();
+    void prefetch();
+    void requestPrefetch(size_t idx);
+    void onPrefetched(uint64_t id, SP<CDecodedImage> image);
+    void swapToNextImage();
+    void showImage(const SP<CDecodedImage>& image);
+    void showFill(const CConfigManager::SFill& fill);
+    void setBackground(uint32_t color);
+    void startTransition(SP<CDecodedImage> outgoing);
+    void onTransitionFrame();
+    void endTransition();
+    void onResized();
+    // the same picture at another size, without a transition
+    void replaceImage(const SP<CDecodedImage>& image);
+
+    // layer positions are logical, m_outputSize is in pixels
+    Hyprutils::Math::Vector2D logicalSize();
 
     class CImagesData;
 
     UP<CImagesData>                    m_imagesData;
-    ASP<Hyprtoolkit::CTimer>           m_timer;
-    SP<Hyprtoolkit::IBackend>          m_backend;
-    SP<Hyprtoolkit::IWindow>           m_window;
-    SP<Hyprtoolkit::CNullElement>      m_null;
-    SP<Hyprtoolkit::CRectangleElement> m_bg;
-    SP<Hyprtoolkit::CImageElement>     m_image;
-    SP<Hyprtoolkit::CTextElement>      m_splash;
+    Hyprtoolkit::eImageFitMode         m_fitMode = Hyprtoolkit::IMAGE_FIT_MODE_COVER;
+    Hyprutils::Math::Vector2D          m_outputSize;
+    std::optional<CConfigManager::SFill> m_fill;
+
+    // upcoming images, slot n holds m_imagesData->upcoming(n)
+    struct SPrefetch {
+        uint64_t          id = 0;
+        SP<CDecodedImage> image;
+        SP<CImageRequest> request;
+        bool              failed = false;
+    };
+
+    size_t                      m_prefetchDepth = 1;
+    int                         m_prefetchTime  = 0;
+    std::deque<SPrefetch>       m_prefetch;
+    uint64_t                    m_prefetchSeq = 0;
+
+    SP<CDecodedImage>           m_currentImage;
+    SP<CFlipGroup>              m_flipGroup;
+    SP<CDecodedImage>           m_heldImage;
+    SP<CImageRequest>           m_currentJob;
+    SP<CImageRequest>           m_resizeJob;
+    bool                        m_swapPending = false;
+    IBackend::Clock::time_point m_swapDeadline;
+
+    eTransition                 m_transitionType = TRANSITION_NONE;
+    std::chrono::milliseconds   m_transitionDuration{0};
+
+    // the outgoing image only lives as long as the transition away from it
+    struct {
+        eTransition                 type  = TRANSITION_NONE;
+        float                       alpha = 0.F;
+        SP<IImageLayer>             layer;
+        SP<CDecodedImage>           image;
+        SP<ITimer>                  timer;
+        IBackend::Clock::time_point start;
+    } m_transition;
+
+    WP<CSlideshowScheduler> m_scheduler;
+    uint64_t                m_slideshowId = 0;
+    SP<IBackend>            m_backend;
+    SP<IWindow>             m_window;
+    uint32_t                m_bgColor = 0xFF000000;
+    SP<IImageLayer>         m_image;
+    bool                    m_splash = false;
+
+    Hyprutils::Signal::CHyprSignalListener m_resized;
 };
 
 class CUI {
@@ -46,21 +138,32 @@ class CUI {
     CUI();
     ~CUI();
 
+    // sets everything up on backend, or on hyprtoolkit without one
+    bool                                     init(SP<IBackend> backend = nullptr);
     bool                                     run();
-    SP<Hyprtoolkit::IBackend>                backend();
+    SP<IBackend>                             backend();
     const std::vector<SP<CWallpaperTarget>>& targets();
 
+    // targets changed by fn show their new wallpapers at the same time
+    void                                     flipTogether(const std::function<void()>& fn);
+
   private:
-    void                              targetChanged(const SP<Hyprtoolkit::IOutput>& mon);
+    void                              targetChanged(const SP<IOutput>& mon);
     void                              targetChanged(const std::string_view& monName);
-    void                              registerOutput(const SP<Hyprtoolkit::IOutput>& mon);
+    void                              registerOutput(const SP<IOutput>& mon);
+
+    SP<IBackend>                      m_backend;
+    SP<CSlideshowScheduler>           m_scheduler;
+    SP<CFlipGroup>                    m_flipGroup;
 
-    SP<Hyprtoolkit::IBackend>         m_backend;
+    std::optional<std::string>        m_splash;
+    SP<HyprlandSocket::CRequest>      m_splashRequest;
 
     std::vector<SP<CWallpaperTarget>> m_targets;
 
     struct {
         Hyprutils::Signal::CHyprSignalListener targetChanged;
+        Hyprutils::Signal::CHyprSignalListener playlistChanged;
         Hyprutils::Signal::CHyprSignalListener newMon;
     } m_listeners;
 };
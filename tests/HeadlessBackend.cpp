@@ -0,0 +1,284 @@
+#include "HeadlessBackend.hpp"
+
+#include <algorithm>
+
+#include <poll.h>
+
+CHeadlessOutput::CHeadlessOutput(std::string port, std::string desc, const Hyprutils::Math::Vector2D& size) : m_port(std::move(port)), m_desc(std::move(desc)), m_size(size) {
+    ;
+}
+
+const std::string& CHeadlessOutput::port() {
+    return m_port;
+}
+
+const std::string& CHeadlessOutput::desc() {
+    return m_desc;
+}
+
+Hyprutils::Math::Vector2D CHeadlessOutput::pixelSize() {
+    return m_size;
+}
+
+uint32_t CHeadlessOutput::fps() {
+    return m_fps;
+}
+
+class CHeadlessImageLayer : public IImageLayer {
+  public:
+    CHeadlessImageLayer(SP<CHeadlessBackend::SCounters> counters) : m_counters(counters) {
+        ;
+    }
+
+    virtual void setImage(const SP<CDecodedImage>& image, Hyprtoolkit::eImageFitMode fitMode) {
+        m_counters->commits++;
+    }
+
+    virtual void setAlpha(float alpha) {
+        m_counters->commits++;
+    }
+
+    virtual void setPosition(const Hyprutils::Math::Vector2D& pos) {
+        m_counters->commits++;
+    }
+
+  private:
+    SP<CHeadlessBackend::SCounters> m_counters;
+};
+
+class CHeadlessWindow : public IWindow {
+  public:
+    CHeadlessWindow(SP<CHeadlessBackend::SCounters> counters, WP<IOutput> output) : m_output(output), m_counters(counters) {
+        m_counters->windows++;
+    }
+
+    virtual void setBackground(uint32_t color) {
+        m_counters->commits++;
+    }
+
+    virtual SP<IImageLayer> addImage(const SP<CDecodedImage>& image, Hyprtoolkit::eImageFitMode fitMode, float alpha) {
+        m_counters->commits++;
+        return makeShared<CHeadlessImageLayer>(m_counters);
+    }
+
+    virtual void removeImage(const SP<IImageLayer>& layer) {
+        m_counters->commits++;
+    }
+
+    virtual void setSplash(const std::string& text, float offset, float alpha) {
+        m_counters->commits++;
+    }
+
+    virtual float scale() {
+        return 1.F;
+    }
+
+    WP<IOutput> m_output;
+
+  private:
+    SP<CHeadlessBackend::SCounters> m_counters;
+};
+
+struct CHeadlessBackend::STimer : public ITimer {
+    Clock::time_point     at;
+    uint64_t              seq = 0;
+    std::function<void()> cb;
+    bool                  fired = false, cancelled = false;
+
+    virtual void          cancel() {
+        cancelled = true;
+    }
+
+    virtual bool          passed() {
+        return fired;
+    }
+};
+
+CHeadlessBackend::CHeadlessBackend() : m_counters(makeShared<SCounters>()) {
+    ;
+}
+
+SP<ITimer> CHeadlessBackend::addTimer(Clock::duration timeout, std::function<void()>&& cb) {
+    auto timer = makeShared<STimer>();
+    timer->at  = m_now + std::max(timeout, Clock::duration{0});
+    timer->seq = ++m_timerSeq;
+    timer->cb  = std::move(cb);
+    m_timers.emplace_back(timer);
+    return timer;
+}
+
+void CHeadlessBackend::addIdle(std::function<void()>&& fn) {
+    m_idles.emplace_back(std::move(fn));
+}
+
+void CHeadlessBackend::addFd(int fd, std::function<void()>&& cb) {
+    m_fds.emplace_back(SFd{.fd = fd, .cb = std::move(cb)});
+}
+
+void CHeadlessBackend::removeFd(int fd) {
+    std::erase_if(m_fds, [fd](const auto& e) { return e.fd == fd; });
+}
+
+IBackend::Clock::time_point CHeadlessBackend::now() {
+    return m_now;
+}
+
+std::vector<SP<IOutput>> CHeadlessBackend::getOutputs() {
+    return {m_outputs.begin(), m_outputs.end()};
+}
+
+SP<IWindow> CHeadlessBackend::createWindow(const SP<IOutput>& output) {
+    const auto WINDOW = makeShared<CHeadlessWindow>(m_counters, output);
+
+    std::erase_if(m_windows, [](const auto& e) { return e.expired(); });
+    m_windows.emplace_back(WINDOW);
+    return WINDOW;
+}
+
+void CHeadlessBackend::enterLoop() {
+    dispatch();
+}
+
+SP<CHeadlessOutput> CHeadlessBackend::addOutput(const std::string& port, const Hyprutils::Math::Vector2D& size) {
+    const auto OUTPUT = m_outputs.emplace_back(makeShared<CHeadlessOutput>(port, "Headless " + port, size));
+    m_events.outputAdded.emit(OUTPUT);
+    return OUTPUT;
+}
+
+void CHeadlessBackend::removeOutput(const std::string& port) {
+    const auto IT = std::ranges::find_if(m_outputs, [&port](const auto& e) { return e->port() == port; });
+
+    if (IT == m_outputs.end())
+        return;
+
+    // gone from getOutputs() before anyone hears about it, like on a real backend
+    const auto OUTPUT = *IT;
+    m_outputs.erase(IT);
+    OUTPUT->m_events.removed.emit();
+}
+
+void CHeadlessBackend::resizeOutput(const std::string& port, const Hyprutils::Math::Vector2D& size) {
+    const auto IT = std::ranges::find_if(m_outputs, [&port](const auto& e) { return e->port() == port; });
+
+    if (IT == m_outputs.end())
+        return;
+
+    (*IT)->m_size = size;
+
+    for (const auto& w : m_windows) {
+        const auto WINDOW = w.lock();
+        if (WINDOW && WINDOW->m_output.lock() == *IT)
+            WINDOW->m_events.resized.emit();
+    }
+}
+
+void CHeadlessBackend::dispatch() {
+    bool busy = true;
+
+    while (busy) {
+        busy = runIdles();
+        busy = runFds(0) || busy;
+        busy = runTimers() || busy;
+    }
+}
+
+bool CHeadlessBackend::poll(std::chrono::milliseconds timeout) {
+    const bool READABLE = runFds(sc<int>(timeout.count()));
+    dispatch();
+    return READABLE;
+}
+
+void CHeadlessBackend::advance(Clock::duration dt, const std::function<void()>& settle) {
+    const auto TARGET = m_now + dt;
+
+    while (true) {
+        dispatch();
+
+        if (settle)
+            settle();
+
+        std::erase_if(m_timers, [](const auto& e) { return e->cancelled; });
+
+        const auto NEXT = std::ranges::min_element(m_timers, [](const auto& a, const auto& b) { return a->at < b->at; });
+
+        if (NEXT == m_timers.end() || (*NEXT)->at > TARGET)
+            break;
+
+        m_now = std::max(m_now, (*NEXT)->at);
+    }
+
+    m_now = TARGET;
+    dispatch();
+
+    if (settle)
+        settle();
+}
+
+bool CHeadlessBackend::runIdles() {
+    if (m_idles.empty())
+        return false;
+
+    // idles added while running wait for the next round
+    auto idles = std::move(m_idles);
+    m_idles.clear();
+
+    for (auto& fn : idles) {
+        fn();
+    }
+
+    return true;
+}
+
+bool CHeadlessBackend::runFds(int timeoutMs) {
+    if (m_fds.empty())
+        return false;
+
+    std::vector<pollfd> fds;
+    for (const auto& f : m_fds) {
+        fds.emplace_back(pollfd{.fd = f.fd, .events = POLLIN, .revents = 0});
+    }
+
+    if (::poll(fds.data(), fds.size(), timeoutMs) <= 0)
+        return false;
+
+    bool ran = false;
+
+    for (const auto& pfd : fds) {
+        if (!(pfd.revents & (POLLIN | POLLHUP | POLLERR)))
+            continue;
+
+        // an earlier callback may have removed it
+        const auto IT = std::ranges::find_if(m_fds, [&pfd](const auto& e) { return e.fd == pfd.fd; });
+        if (IT == m_fds.end())
+            continue;
+
+        const auto CB = IT->cb;
+        CB();
+        ran = true;
+    }
+
+    return ran;
+}
+
+bool CHeadlessBackend::runTimers() {
+    bool ran = false;
+
+    while (true) {
+        std::erase_if(m_timers, [](const auto& e) { return e->cancelled; });
+
+        // ties go in the order they were added
+        const auto NEXT = std::ranges::min_element(m_timers, [](const auto& a, const auto& b) { return a->at < b->at || (a->at == b->at && a->seq < b->seq); });
+
+        if (NEXT == m_timers.end() || (*NEXT)->at > m_now)
+            return ran;
+
+        const auto TIMER = *NEXT;
+        m_timers.erase(NEXT);
+
+        TIMER->fired = true;
+        m_counters->wakeups++;
+        ran = true;
+
+        TIMER->cb();
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../src/backend/Backend.hpp"
+
+#include <string>
+#include <vector>
+
+// A backend without a compositor. Time is virtual and only moves in advance(), fds are
+// real and polled from dispatch() / poll(). Windows draw nothing, they count what
+// would have been redrawn.
+class CHeadlessOutput : public IOutput {
+  public:
+    CHeadlessOutput(std::string port, std::string desc, const Hyprutils::Math::Vector2D& size);
+
+    virtual const std::string&        port();
+    virtual const std::string&        desc();
+    virtual Hyprutils::Math::Vector2D pixelSize();
+    virtual uint32_t                  fps();
+
+    std::string                       m_port, m_desc;
+    Hyprutils::Math::Vector2D         m_size;
+    uint32_t                          m_fps = 60;
+};
+
+class CHeadlessWindow;
+
+class CHeadlessBackend : public IBackend {
+  public:
+    CHeadlessBackend();
+
+    virtual SP<ITimer>               addTimer(Clock::duration timeout, std::function<void()>&& cb);
+    virtual void                     addIdle(std::function<void()>&& fn);
+    virtual void                     addFd(int fd, std::function<void()>&& cb);
+    virtual void                     removeFd(int fd);
+    virtual Clock::time_point        now();
+
+    virtual std::vector<SP<IOutput>> getOutputs();
+    virtual SP<IWindow>              createWindow(const SP<IOutput>& output);
+
+    // there's nothing to wait for, runs what's ready and returns
+    virtual void                     enterLoop();
+
+    SP<CHeadlessOutput>              addOutput(const std::string& port, const Hyprutils::Math::Vector2D& size = {1920, 1080});
+    void                             removeOutput(const std::string& port);
+    // a mode or scale change, its windows hear about it
+    void                             resizeOutput(const std::string& port, const Hyprutils::Math::Vector2D& size);
+
+    // runs idles, readable fds and due timers until there's nothing left, without waiting
+    void                             dispatch();
+    // waits up to timeout for an fd, then dispatches. False if none became readable.
+    bool                             poll(std::chrono::milliseconds timeout);
+    // moves the clock forward, firing timers in deadline order. settle runs after every
+    // wakeup, to wait for work done in real time, like decodes.
+    void                             advance(Clock::duration dt, const std::function<void()>& settle = nullptr);
+
+    struct SCounters {
+        size_t   windows = 0;
+        uint64_t commits = 0; // every window change, a redraw on a real backend
+        uint64_t wakeups = 0; // timers fired
+    };
+
+    SP<SCounters> m_counters;
+
+  private:
+    struct STimer;
+
+    bool                               runIdles();
+    bool                               runFds(int timeoutMs);
+    bool                               runTimers();
+
+    Clock::time_point                  m_now;
+    uint64_t                           m_timerSeq = 0;
+    std::vector<SP<STimer>>            m_timers;
+    std::vector<std::function<void()>> m_idles;
+
+    struct SFd {
+        int                   fd = -1;
+        std::function<void()> cb;
+    };
+
+    std::vector<SFd>                   m_fds;
+    std::vector<SP<CHeadlessOutput>>   m_outputs;
+    std::vector<WP<CHeadlessWindow>>   m_windows;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <jpeglib.h>
+
+#include <hyprutils/memory/Casts.hpp>
+
+#include "../src/helpers/Memory.hpp"
+
+// fn(x, y) gives 0xRRGGBB
+inline bool writeJpeg(const std::string& path, int w, int h, const std::function<uint32_t(int, int)>& fn, int quality = 90) {
+    FILE* file = fopen(path.c_str(), "wbe");
+    if (!file)
+        return false;
+
+    jpeg_compress_struct info;
+    jpeg_error_mgr       err;
+    info.err = jpeg_std_error(&err);
+    jpeg_create_compress(&info);
+    jpeg_stdio_dest(&info, file);
+
+    info.image_width      = w;
+    info.image_height     = h;
+    info.input_components = 3;
+    info.in_color_space   = JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, quality, TRUE);
+    jpeg_start_compress(&info, TRUE);
+
+    std::vector<uint8_t> row(sc<size_t>(w) * 3);
+    while (info.next_scanline < info.image_height) {
+        for (int x = 0; x < w; ++x) {
+            const auto PX  = fn(x, sc<int>(info.next_scanline));
+            row[x * 3]     = sc<uint8_t>(PX >> 16);
+            row[x * 3 + 1] = sc<uint8_t>(PX >> 8);
+            row[x * 3 + 2] = sc<uint8_t>(PX);
+        }
+
+        JSAMPROW ptr = row.data();
+        jpeg_write_scanlines(&info, &ptr, 1);
+    }
+
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../src/config/ConfigManager.hpp"
+
+// The matcher as it was before it got indexed: every lookup scans every setting.
+// Kept as the reference the indexed one has to agree with.
+namespace LinearMatcher {
+    inline bool isWildcard(const std::string& monitor) {
+        return monitor.empty() || monitor == "*";
+    }
+
+    inline std::optional<uint32_t> match(const std::vector<CConfigManager::SSetting>& settings, const std::string& name, const std::string& desc) {
+        for (const auto& s : settings) {
+            if (isWildcard(s.monitor))
+                continue;
+            if (s.monitor != name && !("desc:" + desc).starts_with(s.monitor))
+                continue;
+            return s.id;
+        }
+
+        for (const auto& s : settings) {
+            if (isWildcard(s.monitor))
+                return s.id;
+        }
+
+        return std::nullopt;
+    }
+};
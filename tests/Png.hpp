@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <cairo/cairo.h>
+
+// a single color, 0xRRGGBB
+inline bool writePng(const std::string& path, int w, int h, uint32_t color) {
+    auto* const surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, w, h);
+    auto* const cr      = cairo_create(surface);
+
+    cairo_set_source_rgb(cr, ((color >> 16) & 0xFF) / 255.0, ((color >> 8) & 0xFF) / 255.0, (color & 0xFF) / 255.0);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+
+    const bool OK = cairo_surface_write_to_png(surface, path.c_str()) == CAIRO_STATUS_SUCCESS;
+    cairo_surface_destroy(surface);
+    return OK;
+}
@@ -0,0 +1,339 @@
+#include "../src/config/DirectoryScanner.hpp"
+#include "../src/config/WallpaperMatcher.hpp"
+#include "../src/image/DecodePool.hpp"
+#include "../src/image/JpegDecoder.hpp"
+#include "../src/image/Scaler.hpp"
+#include "../src/helpers/Logger.hpp"
+#include "../src/helpers/Stats.hpp"
+#include "../src/ui/UI.hpp"
+#include "HeadlessBackend.hpp"
+#include "Jpeg.hpp"
+#include "LinearMatcher.hpp"
+#include "Png.hpp"
+#include "shared.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <new>
+#include <print>
+
+#include <unistd.h>
+
+#include <hyprutils/memory/Casts.hpp>
+
+// Not a test: prints how the hot paths perform, to compare before and after a change.
+// Usage: hyprpaper-bench [jpeg...]
+
+static std::atomic<uint64_t> g_allocs = 0, g_allocBytes = 0;
+
+// every allocation on every thread, decode workers included
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+struct SAllocs {
+    uint64_t count = 0, bytes = 0;
+
+    static SAllocs now() {
+        return {g_allocs.load(std::memory_order_relaxed), g_allocBytes.load(std::memory_order_relaxed)};
+    }
+
+    SAllocs since() const {
+        const auto NOW = now();
+        return {NOW.count - count, NOW.bytes - bytes};
+    }
+};
+
+static void benchMatcher() {
+    constexpr const size_t RULES = 1000, MONITORS = 64, CHANGES = 200;
+
+    CWallpaperMatcher matcher;
+
+    std::vector<std::pair<std::string, std::string>> monitors;
+    for (size_t i = 0; i < MONITORS; ++i) {
+        monitors.emplace_back(std::format("DP-{}", i), std::format("Vendor{} Model {} S{}", i % 5, i % 11, i));
+        matcher.registerOutput(monitors.back().first, monitors.back().second);
+    }
+
+    const auto SETTING = [](std::string monitor) {
+        auto playlist = makeShared<CPlaylist>();
+        playlist->add("/wallpapers/a.png");
+        return CConfigManager::SSetting{.monitor = std::move(monitor), .fitMode = "cover", .paths = playlist};
+    };
+
+    std::vector<CConfigManager::SSetting> settings;
+    for (size_t i = 0; i < RULES; ++i) {
+        settings.emplace_back(SETTING(i % 3 == 0 ? std::format("desc:Vendor{} Model {}", i % 5, i) : std::format("HDMI-A-{}", i)));
+    }
+    settings.emplace_back(SETTING("*"));
+    matcher.addStates(std::move(settings));
+
+    // what a wallpaper change over IPC costs
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < CHANGES; ++i) {
+        matcher.addState(SETTING(monitors[i % MONITORS].first));
+    }
+    const double INDEXED = msSince(begin) / CHANGES;
+
+    // the same with every monitor rescanned against every rule, like before the index
+    size_t found = 0;
+    begin        = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < CHANGES; ++i) {
+        for (const auto& [name, desc] : monitors) {
+            found += LinearMatcher::match(matcher.settings(), name, desc).has_value();
+        }
+    }
+    const double LINEAR = msSince(begin) / CHANGES;
+
+    std::println("matcher: {} rules, {} monitors: {:.3f}ms per change indexed, {:.3f}ms linear rematch ({} matched)", RULES, MONITORS, INDEXED, LINEAR, found / CHANGES);
+}
+
+static void benchScanner() {
+    constexpr const size_t FILES = 10000;
+
+    const auto ROOT = std::filesystem::temp_directory_path() / std::format("hyprpaper-bench-{}", getpid());
+    std::filesystem::remove_all(ROOT);
+
+    constexpr const char PNG[] = "\x89PNG\r\n\x1A\n\0\0\0\rIHDR";
+
+    // most have an extension, some need sniffing, some are junk for libmagic
+    for (size_t i = 0; i < FILES; ++i) {
+        const auto DIR = ROOT / std::format("d{}", i % 16);
+        std::filesystem::create_directories(DIR);
+
+        std::ofstream ofs(DIR / (i % 10 < 7 ? std::format("{}.png", i) : std::format("{}", i)), std::ios::binary);
+        if (i % 10 < 9)
+            ofs.write(PNG, sizeof(PNG) - 1);
+        else
+            ofs << "plain text, not an image\n";
+    }
+
+    const auto RESULT = CDirectoryScanner(ROOT.string(), true).scan();
+    if (RESULT) {
+        const double MS = RESULT->elapsed.count() / 1000.0;
+        std::println("scanner: {} files in {:.1f}ms, {:.0f} files/s, {} images", RESULT->entries, MS, RESULT->entries / (MS / 1000.0), RESULT->images.size());
+    } else
+        std::println(stderr, "scanner: {}", RESULT.error());
+
+    std::filesystem::remove_all(ROOT);
+}
+
+constexpr const size_t OUTPUTS = 16;
+
+static std::string outputName(size_t i) {
+    return std::format("HEADLESS-{}", i);
+}
+
+// what a decode costs is up to the images, the scenarios below time everything around it
+static void settle(CHeadlessBackend& backend) {
+    while (g_decodePool->pending() > 0) {
+        backend.poll(std::chrono::milliseconds(100));
+    }
+}
+
+static CConfigManager::SSetting slideshow(std::string monitor, const std::vector<std::string>& images, int timeout) {
+    auto playlist = makeShared<CPlaylist>();
+    for (const auto& i : images) {
+        playlist->add(i);
+    }
+
+    return CConfigManager::SSetting{.monitor = std::move(monitor), .fitMode = "cover", .paths = playlist, .timeout = timeout};
+}
+
+static void benchHotplug(CHeadlessBackend& backend, const std::vector<std::string>& images) {
+    constexpr const size_t ROUNDS = 50;
+
+    g_matcher->addState(slideshow("*", images, 30));
+
+    const auto WINDOWS = backend.m_counters->windows;
+    const auto ALLOCS  = SAllocs::now();
+    const auto BEGIN   = std::chrono::steady_clock::now();
+    size_t     targets = 0;
+
+    for (size_t r = 0; r < ROUNDS; ++r) {
+        for (size_t i = 0; i < OUTPUTS; ++i) {
+            backend.addOutput(outputName(i), i % 2 ? Hyprutils::Math::Vector2D{2560, 1440} : Hyprutils::Math::Vector2D{1920, 1080});
+        }
+
+        settle(backend);
+        targets += g_ui->targets().size();
+
+        for (size_t i = 0; i < OUTPUTS; ++i) {
+            backend.removeOutput(outputName(i));
+        }
+
+        backend.dispatch();
+    }
+
+    const auto MS   = msSince(BEGIN);
+    const auto USED = ALLOCS.since();
+
+    std::println("hotplug: {} outputs x {} rounds: {:.2f}ms per round, {} targets per round, {} windows, {} allocs ({} KiB) per round", OUTPUTS, ROUNDS, MS / ROUNDS,
+                 targets / ROUNDS, backend.m_counters->windows - WINDOWS, USED.count / ROUNDS, USED.bytes / ROUNDS / 1024);
+}
+
+static void benchApplies(CHeadlessBackend& backend, const std::vector<std::string>& images) {
+    constexpr const size_t APPLIES = 10000;
+
+    for (size_t i = 0; i < OUTPUTS; ++i) {
+        backend.addOutput(outputName(i));
+    }
+
+    settle(backend);
+
+    const auto WINDOWS = backend.m_counters->windows;
+    const auto COMMITS = backend.m_counters->commits;
+    const auto ALLOCS  = SAllocs::now();
+    const auto BEGIN   = std::chrono::steady_clock::now();
+
+    // shaped like an IPC wallpaper object: one output, one path
+    for (size_t i = 0; i < APPLIES; ++i) {
+        g_matcher->addState(slideshow(outputName(i % OUTPUTS), {images[i % images.size()]}, 0));
+        backend.dispatch();
+    }
+
+    settle(backend);
+
+    const auto MS   = msSince(BEGIN);
+    const auto USED = ALLOCS.since();
+
+    std::println("ipc: {} applies over {} outputs: {:.1f}us per apply, {} new windows, {} redraws, {} allocs ({} B) per apply", APPLIES, OUTPUTS, MS * 1000.0 / APPLIES,
+                 backend.m_counters->windows - WINDOWS, backend.m_counters->commits - COMMITS, USED.count / APPLIES, USED.bytes / APPLIES);
+}
+
+static void benchSlideshow(CHeadlessBackend& backend, const std::vector<std::string>& images) {
+    constexpr const auto DURATION = std::chrono::hours(24);
+
+    // still connected from benchApplies
+    for (size_t i = 0; i < OUTPUTS; ++i) {
+        g_matcher->addState(slideshow(outputName(i), images, 30));
+    }
+
+    settle(backend);
+
+    const auto TICKS   = g_stats->slideshow.ticks.load();
+    const auto SWAPS   = g_stats->slideshow.swaps.load();
+    const auto LATE    = g_stats->slideshow.lateSwaps.load();
+    const auto WAKEUPS = backend.m_counters->wakeups;
+    const auto COMMITS = backend.m_counters->commits;
+    const auto ALLOCS  = SAllocs::now();
+    const auto BEGIN   = std::chrono::steady_clock::now();
+
+    backend.advance(DURATION, [&backend] { settle(backend); });
+
+    const auto MS     = msSince(BEGIN);
+    const auto USED   = ALLOCS.since();
+    const auto NTICKS = g_stats->slideshow.ticks.load() - TICKS;
+
+    std::println("slideshow: {} outputs, {}h of virtual time in {:.0f}ms: {} ticks, {} swaps ({} late), {} wakeups, {} redraws, {} allocs per tick", OUTPUTS,
+                 DURATION.count(), MS, NTICKS, g_stats->slideshow.swaps.load() - SWAPS, g_stats->slideshow.lateSwaps.load() - LATE, backend.m_counters->wakeups - WAKEUPS,
+                 backend.m_counters->commits - COMMITS, USED.count / std::max<uint64_t>(NTICKS, 1));
+}
+
+// runs the whole thing, minus wayland, on the headless backend
+static void benchUI() {
+    const auto DIR = std::filesystem::temp_directory_path() / std::format("hyprpaper-bench-ui-{}", getpid());
+    std::filesystem::create_directories(DIR);
+
+    std::vector<std::string> images;
+    for (uint32_t i = 0; i < 8; ++i) {
+        const auto PATH = (DIR / std::format("{}.png", i)).string();
+        if (writePng(PATH, 640, 360, 0x204060 * (i + 1)))
+            images.emplace_back(PATH);
+    }
+
+    std::ofstream(DIR / "hyprpaper.conf") << "splash = false\nipc = false\ndisk_cache = 0\n";
+
+    g_logger->setLogLevel(LOG_ERR);
+    g_config = makeUnique<CConfigManager>((DIR / "hyprpaper.conf").string());
+
+    const auto BACKEND = makeShared<CHeadlessBackend>();
+    g_ui               = makeUnique<CUI>();
+
+    if (images.empty() || !g_config->init() || !g_ui->init(BACKEND)) {
+        std::println(stderr, "ui: setup failed");
+        std::filesystem::remove_all(DIR);
+        return;
+    }
+
+    benchHotplug(*BACKEND, images);
+    benchApplies(*BACKEND, images);
+    benchSlideshow(*BACKEND, images);
+
+    g_ui.reset();
+    g_config.reset();
+
+    std::filesystem::remove_all(DIR);
+}
+
+static void benchJpeg(const std::string& path) {
+    const Hyprutils::Math::Vector2D OUTPUT = {1920, 1080};
+
+    auto                            begin = std::chrono::steady_clock::now();
+    const auto                      FULL  = CDecodedImage::fromFile(path);
+    if (!FULL) {
+        std::println(stderr, "jpeg: {}: {}", path, FULL.error());
+        return;
+    }
+    Scaler::scale(*FULL, OUTPUT, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+    const auto FULLMS = msSince(begin);
+
+    begin               = std::chrono::steady_clock::now();
+    const auto DECODED  = JpegDecoder::decodeScaled(path, OUTPUT, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+    const auto FASTMS   = msSince(begin);
+    const bool FALLBACK = !DECODED || !*DECODED;
+    if (!FALLBACK)
+        Scaler::scale(*DECODED, OUTPUT, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+    const auto SCALEDMS = msSince(begin);
+
+    const auto SIZE = (*FULL)->size();
+    std::println("jpeg: {}x{} onto {}x{}: full decode + scale {:.1f}ms, scaled decode + scale {:.1f}ms (decode {:.1f}ms){}", SIZE.x, SIZE.y, OUTPUT.x, OUTPUT.y, FULLMS,
+                 SCALEDMS, FASTMS, FALLBACK ? ", no reduction possible" : "");
+}
+
+int main(int argc, char** argv) {
+    benchMatcher();
+    benchScanner();
+    benchUI();
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            benchJpeg(argv[i]);
+        }
+
+        return 0;
+    }
+
+    const auto DIR = std::filesystem::temp_directory_path() / std::format("hyprpaper-bench-{}", getpid());
+    std::filesystem::create_directories(DIR);
+
+    for (const auto& [w, h] : std::vector<std::pair<int, int>>{{2560, 1440}, {3840, 2160}, {7680, 4320}}) {
+        const auto PATH = (DIR / std::format("{}x{}.jpg", w, h)).string();
+        // noisy enough to not compress to nothing
+        const auto NOISE = [w, h](int x, int y) { return sc<uint32_t>(((x ^ y) & 0xFF) << 16 | (x * 255 / (w - 1)) << 8 | (y * 255 / (h - 1))); };
+
+        if (writeJpeg(PATH, w, h, NOISE))
+            benchJpeg(PATH);
+    }
+
+    std::filesystem::remove_all(DIR);
+
+    return 0;
+}
@@ -0,0 +1,231 @@
+#include "../src/image/JpegDecoder.hpp"
+#include "../src/image/Scaler.hpp"
+#include "Jpeg.hpp"
+#include "shared.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <unistd.h>
+
+#include <hyprutils/memory/Casts.hpp>
+
+using namespace Hyprutils::Math;
+
+static uint32_t pixel(cairo_surface_t* surface, int x, int y) {
+    cairo_surface_flush(surface);
+    const auto* DATA = cairo_image_surface_get_data(surface) + sc<size_t>(y) * cairo_image_surface_get_stride(surface);
+    return rc<const uint32_t*>(DATA)[x];
+}
+
+static int channel(uint32_t px, int shift) {
+    return sc<int>((px >> shift) & 0xFF);
+}
+
+// fn(x, y) gives 0xAARRGGBB, premultiplied
+static SP<CDecodedImage> makeImage(int w, int h, cairo_format_t format, const std::function<uint32_t(int, int)>& fn) {
+    auto* const surface = cairo_image_surface_create(format, w, h);
+    auto* const DATA    = cairo_image_surface_get_data(surface);
+    const auto  STRIDE  = cairo_image_surface_get_stride(surface);
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            rc<uint32_t*>(DATA + sc<size_t>(y) * STRIDE)[x] = fn(x, y);
+        }
+    }
+
+    cairo_surface_mark_dirty(surface);
+
+    return makeShared<CDecodedImage>("test", makeShared<Hyprgraphics::CCairoSurface>(surface));
+}
+
+static void testTargetSize() {
+    using namespace Hyprtoolkit;
+
+    EXPECT(Scaler::targetSize({3840, 2160}, {1920, 1080}, IMAGE_FIT_MODE_COVER) == Vector2D(1920, 1080));
+    EXPECT(Scaler::targetSize({4000, 2000}, {1920, 1080}, IMAGE_FIT_MODE_COVER) == Vector2D(2160, 1080));
+    EXPECT(Scaler::targetSize({4000, 2000}, {1920, 1080}, IMAGE_FIT_MODE_CONTAIN) == Vector2D(1920, 960));
+    EXPECT(Scaler::targetSize({4000, 500}, {1920, 1080}, IMAGE_FIT_MODE_STRETCH) == Vector2D(1920, 500));
+    // never upscaled
+    EXPECT(Scaler::targetSize({1000, 1000}, {1920, 1080}, IMAGE_FIT_MODE_COVER) == Vector2D(1000, 1000));
+    EXPECT(Scaler::targetSize({1000, 1000}, {0, 0}, IMAGE_FIT_MODE_COVER) == Vector2D(1000, 1000));
+    // tiles are repeated as they are, whatever the output
+    EXPECT(Scaler::targetSize({32, 32}, {7680, 2160}, IMAGE_FIT_MODE_TILE) == Vector2D(32, 32));
+}
+
+static void testTile() {
+    const auto TILE   = makeImage(32, 32, CAIRO_FORMAT_ARGB32, [](int x, int y) { return (x + y) % 2 ? 0xFFFFFFFF : 0xFF000000; });
+    const auto SCALED = Scaler::scale(TILE, {7680, 2160}, Hyprtoolkit::IMAGE_FIT_MODE_TILE);
+
+    EXPECT(SCALED && *SCALED == TILE);
+    EXPECT(TILE->bytes() == 32 * 32 * 4);
+}
+
+// 4:1 on both axes, so every output pixel has an exact 4x4 block to compare with
+static void testBoxAverage() {
+    const auto RAMP = makeImage(400, 300, CAIRO_FORMAT_RGB24, [](int x, int y) {
+        const auto R = sc<uint32_t>(x * 255 / 399), G = sc<uint32_t>(y * 255 / 299), B = sc<uint32_t>((x + y) % 256);
+        return 0xFF000000 | (R << 16) | (G << 8) | B;
+    });
+
+    const auto SCALED = Scaler::scale(RAMP, {100, 75}, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+    EXPECT(SCALED && (*SCALED)->size() == Vector2D(100, 75));
+    if (!SCALED)
+        return;
+
+    auto* const SRC      = RAMP->surface()->cairo();
+    auto* const DST      = (*SCALED)->surface()->cairo();
+    int         worst[2] = {0, 0};
+
+    for (int y = 0; y < 75; ++y) {
+        for (int x = 0; x < 100; ++x) {
+            for (int c = 0; c < 2; ++c) {
+                const int SHIFT = c == 0 ? 16 : 8;
+                int       sum   = 0;
+                for (int by = 0; by < 4; ++by) {
+                    for (int bx = 0; bx < 4; ++bx) {
+                        sum += channel(pixel(SRC, x * 4 + bx, y * 4 + by), SHIFT);
+                    }
+                }
+
+                worst[c] = std::max(worst[c], std::abs(channel(pixel(DST, x, y), SHIFT) - (sum + 8) / 16));
+            }
+        }
+    }
+
+    // the ramps are smooth, so the wider kernel barely moves them. Edges included.
+    EXPECT(worst[0] <= 3);
+    EXPECT(worst[1] <= 3);
+
+    // a 1px checkerboard averages to grey. Point sampling would keep black and white.
+    const auto CHECKER = makeImage(400, 300, CAIRO_FORMAT_RGB24, [](int x, int y) { return (x + y) % 2 ? 0xFFFFFFFF : 0xFF000000; });
+    const auto GREY    = Scaler::scale(CHECKER, {100, 75}, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+    EXPECT(GREY);
+    if (!GREY)
+        return;
+
+    int worstGrey = 0;
+    for (int y = 0; y < 75; ++y) {
+        for (int x = 0; x < 100; ++x) {
+            worstGrey = std::max(worstGrey, std::abs(channel(pixel((*GREY)->surface()->cairo(), x, y), 8) - 128));
+        }
+    }
+
+    EXPECT(worstGrey <= 32);
+}
+
+// edges must not fade towards transparent black
+static void testEdges() {
+    const auto SOLID  = makeImage(333, 257, CAIRO_FORMAT_ARGB32, [](int, int) { return 0xFFC04020; });
+    const auto SCALED = Scaler::scale(SOLID, {100, 77}, Hyprtoolkit::IMAGE_FIT_MODE_STRETCH);
+    EXPECT(SCALED);
+    if (!SCALED)
+        return;
+
+    auto* const DST   = (*SCALED)->surface()->cairo();
+    const auto  SIZE  = (*SCALED)->size();
+    bool        exact = true;
+
+    for (int y = 0; y < sc<int>(SIZE.y); ++y) {
+        for (int x = 0; x < sc<int>(SIZE.x); ++x) {
+            const auto PX = pixel(DST, x, y);
+            if (channel(PX, 24) != 0xFF || std::abs(channel(PX, 16) - 0xC0) > 1 || std::abs(channel(PX, 8) - 0x40) > 1 || std::abs(channel(PX, 0) - 0x20) > 1)
+                exact = false;
+        }
+    }
+
+    EXPECT(exact);
+}
+
+// small, the image element stretches it. Corners get the first and last color.
+static void testGradient() {
+    const auto HORIZONTAL = CDecodedImage::gradient("gradient", {0xFFFF0000, 0xFF0000FF}, 0, {1920, 1080});
+    EXPECT(HORIZONTAL && (*HORIZONTAL)->size() == Vector2D(256, 144));
+    if (HORIZONTAL) {
+        auto* const SURFACE = (*HORIZONTAL)->surface()->cairo();
+        EXPECT(channel(pixel(SURFACE, 0, 72), 16) > 240 && channel(pixel(SURFACE, 0, 72), 0) < 15);
+        EXPECT(channel(pixel(SURFACE, 255, 72), 0) > 240 && channel(pixel(SURFACE, 255, 72), 16) < 15);
+        EXPECT(channel(pixel(SURFACE, 0, 0), 24) == 0xFF);
+    }
+
+    const auto VERTICAL = CDecodedImage::gradient("gradient", {0xFFFF0000, 0xFF00FF00, 0xFF0000FF}, 90, {1080, 1920});
+    EXPECT(VERTICAL && (*VERTICAL)->size() == Vector2D(144, 256));
+    if (VERTICAL) {
+        auto* const SURFACE = (*VERTICAL)->surface()->cairo();
+        EXPECT(channel(pixel(SURFACE, 72, 0), 16) > 240);
+        EXPECT(channel(pixel(SURFACE, 72, 128), 8) > 200);
+        EXPECT(channel(pixel(SURFACE, 72, 255), 0) > 240);
+    }
+}
+
+static void testJpeg() {
+    const auto DIR = std::filesystem::temp_directory_path() / std::format("hyprpaper-test-{}", getpid());
+    std::filesystem::create_directories(DIR);
+
+    const auto JPEG = (DIR / "gradient.jpg").string();
+    EXPECT(writeJpeg(JPEG, 1600, 1200, [](int x, int y) { return sc<uint32_t>((x * 255 / 1599) << 16 | (y * 255 / 1199) << 8 | 128); }, 95));
+
+    // 1/4 covers it exactly
+    const auto QUARTER = JpegDecoder::decodeScaled(JPEG, {400, 300}, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+    EXPECT(QUARTER && *QUARTER && (*QUARTER)->size() == Vector2D(400, 300));
+
+    // 1/4 would be too small, so 1/2
+    const auto HALF = JpegDecoder::decodeScaled(JPEG, {500, 300}, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+    EXPECT(HALF && *HALF && (*HALF)->size() == Vector2D(800, 600));
+
+    // nothing to save, left to the regular decoders
+    const auto FULL = JpegDecoder::decodeScaled(JPEG, {1920, 1080}, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+    EXPECT(FULL && !*FULL);
+
+    // scaled decode + scaler has to look like full decode + scaler
+    const auto REFERENCE = CDecodedImage::fromFile(JPEG);
+    EXPECT(REFERENCE);
+    if (HALF && *HALF && REFERENCE) {
+        const auto A = Scaler::scale(*HALF, {500, 300}, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+        const auto B = Scaler::scale(*REFERENCE, {500, 300}, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+        EXPECT(A && B && (*A)->size() == (*B)->size());
+
+        if (A && B && (*A)->size() == (*B)->size()) {
+            double     diff = 0;
+            const auto SIZE = (*A)->size();
+            for (int y = 0; y < sc<int>(SIZE.y); ++y) {
+                for (int x = 0; x < sc<int>(SIZE.x); ++x) {
+                    const auto PA = pixel((*A)->surface()->cairo(), x, y), PB = pixel((*B)->surface()->cairo(), x, y);
+                    for (const int SHIFT : {16, 8, 0}) {
+                        diff += std::abs(channel(PA, SHIFT) - channel(PB, SHIFT));
+                    }
+                }
+            }
+
+            EXPECT(diff / (SIZE.x * SIZE.y * 3) < 2.0);
+        }
+    }
+
+    // not a JPEG at all
+    const auto TEXT = (DIR / "fake.jpg").string();
+    if (FILE* f = fopen(TEXT.c_str(), "we")) {
+        fputs("definitely not a jpeg", f);
+        fclose(f);
+    }
+
+    const auto NOTJPEG = JpegDecoder::decodeScaled(TEXT, {400, 300}, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+    EXPECT(NOTJPEG && !*NOTJPEG);
+
+    const auto MISSING = JpegDecoder::decodeScaled((DIR / "missing.jpg").string(), {400, 300}, Hyprtoolkit::IMAGE_FIT_MODE_COVER);
+    EXPECT(MISSING && !*MISSING);
+
+    std::filesystem::remove_all(DIR);
+}
+
+int main() {
+    testTargetSize();
+    testTile();
+    testBoxAverage();
+    testEdges();
+    testGradient();
+    testJpeg();
+
+    return testResult("image");
+}
@@ -0,0 +1,139 @@
+#include "../src/config/WallpaperMatcher.hpp"
+#include "LinearMatcher.hpp"
+#include "shared.hpp"
+
+#include <algorithm>
+#include <format>
+#include <map>
+#include <random>
+
+struct SMonitor {
+    std::string name, desc;
+};
+
+static std::vector<SMonitor> makeMonitors(size_t n) {
+    std::vector<SMonitor> monitors;
+
+    for (size_t i = 0; i < n; ++i) {
+        monitors.emplace_back(SMonitor{.name = std::format("DP-{}", i), .desc = std::format("Vendor{} Model {} S{}", i % 5, i % 11, i)});
+    }
+
+    return monitors;
+}
+
+static CConfigManager::SSetting makeSetting(std::string monitor) {
+    auto playlist = makeShared<CPlaylist>();
+    playlist->add(std::format("/wallpapers/{}.png", monitor));
+
+    return CConfigManager::SSetting{.monitor = std::move(monitor), .fitMode = "cover", .paths = playlist};
+}
+
+static std::string randomRule(std::mt19937& rng, const std::vector<SMonitor>& monitors) {
+    const auto& MON = monitors[rng() % monitors.size()];
+
+    switch (rng() % 6) {
+        case 0: return MON.name;
+        case 1: return std::format("HDMI-A-{}", rng() % 4); // never connected
+        case 2: return "desc:" + MON.desc;
+        case 3: return "desc:" + MON.desc.substr(0, rng() % (MON.desc.size() + 1));
+        case 4: return "desc:Vendor" + std::to_string(rng() % 5);
+        default: return rng() % 2 ? "*" : "";
+    }
+}
+
+// old linear scan vs. the index, and every change must have been announced
+class CDifferential {
+  public:
+    CDifferential() {
+        m_listener = m_matcher.m_events.monitorConfigChanged.listen([this](const std::string_view& name) { m_seen[std::string{name}] = current(name); });
+    }
+
+    CWallpaperMatcher m_matcher;
+
+    void              registerOutput(const SMonitor& mon) {
+        if (std::ranges::find(m_connected, mon.name, &SMonitor::name) != m_connected.end())
+            return;
+
+        m_connected.emplace_back(mon);
+        m_matcher.registerOutput(mon.name, mon.desc);
+    }
+
+    void unregisterOutput(size_t idx) {
+        m_matcher.unregisterOutput(m_connected[idx].name);
+        m_seen.erase(m_connected[idx].name);
+        m_connected.erase(m_connected.begin() + idx);
+    }
+
+    size_t connected() const {
+        return m_connected.size();
+    }
+
+    void check() {
+        for (const auto& mon : m_connected) {
+            const auto GOT = current(mon.name);
+
+            EXPECT(GOT == LinearMatcher::match(m_matcher.settings(), mon.name, mon.desc));
+            EXPECT(GOT == (m_seen.contains(mon.name) ? m_seen[mon.name] : std::nullopt));
+        }
+    }
+
+  private:
+    std::optional<uint32_t> current(const std::string_view& name) {
+        const auto IT = std::ranges::find(m_connected, name, &SMonitor::name);
+        if (IT == m_connected.end())
+            return std::nullopt;
+
+        const auto SETTING = m_matcher.getSetting(IT->name, IT->desc);
+        return SETTING ? std::optional{SETTING->get().id} : std::nullopt;
+    }
+
+    std::vector<SMonitor>                          m_connected;
+    std::map<std::string, std::optional<uint32_t>> m_seen;
+    Hyprutils::Signal::CHyprSignalListener         m_listener;
+};
+
+int main() {
+    const auto   MONITORS = makeMonitors(24);
+    std::mt19937 rng(1234);
+
+    CDifferential diff;
+
+    for (size_t i = 0; i < 8; ++i) {
+        diff.registerOutput(MONITORS[i]);
+    }
+
+    for (size_t step = 0; step < 4000; ++step) {
+        switch (rng() % 6) {
+            case 0:
+            case 1: diff.m_matcher.addState(makeSetting(randomRule(rng, MONITORS))); break;
+            case 2: {
+                std::vector<CConfigManager::SSetting> batch;
+                for (size_t i = rng() % 4; i > 0; --i) {
+                    batch.emplace_back(makeSetting(randomRule(rng, MONITORS)));
+                }
+                diff.m_matcher.addStates(std::move(batch));
+                break;
+            }
+            case 3: {
+                // config entries are keyed by monitor, so never twice the same
+                std::vector<CConfigManager::SSetting> config;
+                for (size_t i = rng() % 6; i > 0; --i) {
+                    auto rule = randomRule(rng, MONITORS);
+                    if (std::ranges::none_of(config, [&rule](const auto& e) { return e.monitor == rule; }))
+                        config.emplace_back(makeSetting(std::move(rule)));
+                }
+                diff.m_matcher.applyConfig(std::move(config));
+                break;
+            }
+            case 4: diff.registerOutput(MONITORS[rng() % MONITORS.size()]); break;
+            default:
+                if (diff.connected() > 0)
+                    diff.unregisterOutput(rng() % diff.connected());
+                break;
+        }
+
+        diff.check();
+    }
+
+    return testResult("matcher");
+}
@@ -0,0 +1,97 @@
+#include "../src/config/Playlist.hpp"
+#include "shared.hpp"
+
+#include <algorithm>
+#include <format>
+#include <numeric>
+
+static void testPermutation() {
+    // around the powers of 4 the Feistel domain grows, so those sizes matter most
+    std::vector<size_t> sizes = {0, 1, 2, 3, 4, 5, 15, 16, 17, 63, 64, 65, 255, 256, 257, 1000, 4095, 4096, 4097, 100000};
+
+    for (const auto N : sizes) {
+        for (uint64_t seed : {0ULL, 1ULL, 42ULL, 0xDEADBEEFULL, ~0ULL}) {
+            CIndexPermutation perm(N, seed);
+            std::vector<bool> hit(N, false);
+            bool              ok = true;
+
+            for (size_t i = 0; i < N; ++i) {
+                const auto IDX = perm.at(i);
+
+                if (IDX >= N || hit[IDX]) {
+                    ok = false;
+                    break;
+                }
+
+                hit[IDX] = true;
+            }
+
+            expect(ok, std::format("permutation of {} with seed {} is a bijection", N, seed));
+
+            // same seed, same order
+            CIndexPermutation again(N, seed);
+            for (size_t i = 0; i < std::min<size_t>(N, 64); ++i) {
+                EXPECT(perm.at(i) == again.at(i));
+            }
+        }
+    }
+
+    // different seeds should actually shuffle differently
+    CIndexPermutation a(1000, 1), b(1000, 2);
+    size_t            same = 0;
+    for (size_t i = 0; i < 1000; ++i) {
+        same += a.at(i) == b.at(i);
+    }
+    EXPECT(same < 100);
+}
+
+static void testPlaylist() {
+    CPlaylist                playlist;
+    std::vector<std::string> paths;
+
+    for (size_t i = 0; i < 500; ++i) {
+        paths.emplace_back(std::format("/home/user/wallpapers/{}/image-{}.png", i % 7, i));
+    }
+    paths.emplace_back("/no-dir.jpg");
+    paths.emplace_back("relative.jpg");
+
+    for (const auto& p : paths) {
+        EXPECT(playlist.add(p));
+    }
+
+    EXPECT(playlist.size() == paths.size());
+    EXPECT(!playlist.empty());
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        EXPECT(playlist.at(i) == paths[i]);
+        EXPECT(playlist.find(paths[i]) == i);
+    }
+
+    EXPECT(!playlist.find("/home/user/wallpapers/0/missing.png"));
+    EXPECT(!playlist.find("/home/user/wallpapers/9/image-0.png"));
+
+    // interning dirs has to be cheaper than plain strings
+    EXPECT(playlist.memoryUsage() < std::accumulate(paths.begin(), paths.end(), size_t{0}, [](size_t acc, const auto& p) { return acc + p.size(); }));
+
+    playlist.shuffle();
+    playlist.shrinkToFit();
+
+    std::vector<std::string> shuffled;
+    for (size_t i = 0; i < playlist.size(); ++i) {
+        shuffled.emplace_back(playlist.at(i));
+        EXPECT(playlist.find(shuffled.back()) == i);
+    }
+
+    std::ranges::sort(shuffled);
+    std::ranges::sort(paths);
+    EXPECT(shuffled == paths);
+
+    EXPECT(CPlaylist{}.empty());
+}
+
+int main() {
+    testPermutation();
+    testPlaylist();
+
+    return testResult("playlist");
+}
@@ -0,0 +1,92 @@
+#include "../src/config/DirectoryScanner.hpp"
+#include "../src/config/ImageClassifier.hpp"
+#include "../src/helpers/Memory.hpp"
+#include "shared.hpp"
+
+#include <array>
+#include <filesystem>
+#include <format>
+#include <fstream>
+
+#include <unistd.h>
+
+#include <hyprutils/memory/Casts.hpp>
+
+using namespace ImageClassifier;
+
+constexpr const std::array<uint8_t, 16> PNG_HEADER  = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n', 0, 0, 0, 13, 'I', 'H', 'D', 'R'};
+constexpr const std::array<uint8_t, 16> JPEG_HEADER = {0xFF, 0xD8, 0xFF, 0xE0, 0, 16, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1};
+constexpr const std::array<uint8_t, 16> WEBP_HEADER = {'R', 'I', 'F', 'F', 0x24, 0, 0, 0, 'W', 'E', 'B', 'P', 'V', 'P', '8', ' '};
+
+static void write(const std::filesystem::path& path, std::span<const uint8_t> data) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream ofs(path, std::ios::binary);
+    ofs.write(rc<const char*>(data.data()), data.size());
+}
+
+static void write(const std::filesystem::path& path, std::string_view text) {
+    write(path, std::span{rc<const uint8_t*>(text.data()), text.size()});
+}
+
+static void testSniff() {
+    EXPECT(sniffHeader(PNG_HEADER) == IMAGE_TYPE_PNG);
+    EXPECT(sniffHeader(JPEG_HEADER) == IMAGE_TYPE_JPEG);
+    EXPECT(sniffHeader(WEBP_HEADER) == IMAGE_TYPE_WEBP);
+    EXPECT(sniffHeader(std::span<const uint8_t>{}) == IMAGE_TYPE_UNKNOWN);
+    EXPECT(sniffHeader(std::span{PNG_HEADER}.first(4)) == IMAGE_TYPE_UNKNOWN);
+
+    constexpr const std::string_view TEXT = "just some text, nothing to see";
+    EXPECT(sniffHeader(std::span{rc<const uint8_t*>(TEXT.data()), TEXT.size()}) == IMAGE_TYPE_UNKNOWN);
+}
+
+static void testScan() {
+    const auto ROOT = std::filesystem::temp_directory_path() / std::format("hyprpaper-test-{}", getpid());
+    std::filesystem::remove_all(ROOT);
+
+    write(ROOT / "a.png", PNG_HEADER);
+    write(ROOT / "b.JPG", JPEG_HEADER);
+    write(ROOT / "no-extension", PNG_HEADER);
+    write(ROOT / "misnamed.dat", JPEG_HEADER);
+    write(ROOT / "notes.txt", "some notes about the wallpapers\n");
+    write(ROOT / "script.sh", "#!/bin/sh\necho hi\n");
+    write(ROOT / "nested/deeper/c.webp", WEBP_HEADER);
+    write(ROOT / "nested/readme", "not an image either\n");
+    std::filesystem::create_symlink(ROOT / "a.png", ROOT / "link.png");
+    std::filesystem::create_directory_symlink(ROOT / "nested", ROOT / "loop");
+
+    const auto PREFIX = ROOT.string() + "/";
+
+    const auto FLAT = CDirectoryScanner(ROOT.string(), false).scan();
+    EXPECT(FLAT);
+    if (FLAT) {
+        std::vector<std::string> got;
+        for (size_t i = 0; i < FLAT->images.size(); ++i) {
+            got.emplace_back(FLAT->images.at(i));
+        }
+
+        // sorted, so never depending on which worker got there first
+        EXPECT((got == std::vector<std::string>{PREFIX + "a.png", PREFIX + "b.JPG", PREFIX + "link.png", PREFIX + "misnamed.dat", PREFIX + "no-extension"}));
+        EXPECT(FLAT->dirs == 1);
+    }
+
+    // directory symlinks aren't followed, so loop/ doesn't show up twice
+    const auto DEEP = CDirectoryScanner(ROOT.string(), true).scan();
+    EXPECT(DEEP);
+    if (DEEP) {
+        EXPECT(DEEP->images.size() == 6);
+        EXPECT(DEEP->images.find(PREFIX + "nested/deeper/c.webp").has_value());
+        EXPECT(!DEEP->images.find(PREFIX + "loop/deeper/c.webp").has_value());
+        EXPECT(DEEP->dirs == 3);
+    }
+
+    EXPECT(!CDirectoryScanner((ROOT / "missing").string(), true).scan());
+
+    std::filesystem::remove_all(ROOT);
+}
+
+int main() {
+    testSniff();
+    testScan();
+
+    return testResult("scanner");
+}
@@ -0,0 +1,108 @@
+#include "../src/config/ConfigManager.hpp"
+#include "../src/helpers/Logger.hpp"
+#include "../src/ui/SlideshowScheduler.hpp"
+#include "HeadlessBackend.hpp"
+#include "shared.hpp"
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+// Timers fire late by whatever m_late says, like on a busy machine. Time is virtual,
+// so 10k ticks of 30s take no time at all.
+class CLateBackend : public CHeadlessBackend {
+  public:
+    virtual SP<ITimer> addTimer(Clock::duration timeout, std::function<void()>&& cb) {
+        return CHeadlessBackend::addTimer(timeout + (m_late ? m_late() : Clock::duration{0}), std::move(cb));
+    }
+
+    std::function<Clock::duration()> m_late;
+};
+
+static void testNoDrift() {
+    constexpr const std::chrono::milliseconds PERIOD = 30s, LEAD = 5s, MAXLATE = 250ms;
+    constexpr const size_t                    TICKS  = 10000;
+
+    const auto BACKEND = makeShared<CLateBackend>();
+    uint64_t   seed    = 1;
+
+    BACKEND->m_late = [&seed, MAXLATE] {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return IBackend::Clock::duration{std::chrono::milliseconds((seed >> 33) % MAXLATE.count())};
+    };
+
+    CSlideshowScheduler                      scheduler(BACKEND);
+    const auto                               START = BACKEND->now();
+    std::vector<IBackend::Clock::time_point> ticks, leads;
+
+    const auto ID = scheduler.add(PERIOD, LEAD, [&] { ticks.emplace_back(BACKEND->now()); }, [&] { leads.emplace_back(BACKEND->now()); });
+
+    BACKEND->advance(PERIOD * TICKS + 1s);
+
+    EXPECT(ticks.size() == TICKS);
+    EXPECT(leads.size() == TICKS);
+
+    // every tick is late by at most one wakeup, never by the sum of all before it
+    bool onTime = true;
+    for (size_t i = 0; i < ticks.size() && i < leads.size(); ++i) {
+        const auto DUE = START + PERIOD * (i + 1);
+
+        onTime = onTime && ticks[i] >= DUE && ticks[i] - DUE < MAXLATE;
+        onTime = onTime && leads[i] >= DUE - LEAD && leads[i] - (DUE - LEAD) < MAXLATE;
+    }
+
+    expect(onTime, std::format("{} ticks stay within {}ms of their deadline", TICKS, MAXLATE.count()));
+    EXPECT(scheduler.deadline(ID) == START + PERIOD * (TICKS + 1));
+}
+
+static void testMissedTicks() {
+    constexpr const auto PERIOD = 30s;
+
+    const auto BACKEND = makeShared<CLateBackend>();
+    bool       stalled = false;
+
+    // only the first wakeup is late, by more than two periods
+    BACKEND->m_late = [&stalled] {
+        if (stalled)
+            return IBackend::Clock::duration{0};
+
+        stalled = true;
+        return IBackend::Clock::duration{75s};
+    };
+
+    CSlideshowScheduler                      scheduler(BACKEND);
+    const auto                               START = BACKEND->now();
+    std::vector<IBackend::Clock::time_point> ticks;
+
+    scheduler.add(PERIOD, 0ms, [&] { ticks.emplace_back(BACKEND->now()); }, nullptr);
+
+    BACKEND->advance(200s);
+
+    // the ticks at 60s and 90s are skipped, not run back to back, and the ones after stay on the grid
+    EXPECT(ticks == (std::vector{START + 105s, START + 120s, START + 150s, START + 180s}));
+}
+
+int main() {
+    const auto DIR = std::filesystem::temp_directory_path() / std::format("hyprpaper-test-scheduler-{}", getpid());
+    std::filesystem::create_directories(DIR);
+
+    std::ofstream(DIR / "hyprpaper.conf") << "splash = false\nipc = false\n";
+
+    g_logger->setLogLevel(LOG_ERR);
+    g_config = makeUnique<CConfigManager>((DIR / "hyprpaper.conf").string());
+
+    if (g_config->init()) {
+        testNoDrift();
+        testMissedTicks();
+    } else
+        EXPECT(!"setup failed");
+
+    g_config.reset();
+
+    std::filesystem::remove_all(DIR);
+
+    return testResult("scheduler");
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <print>
+#include <source_location>
+#include <string_view>
+
+inline int g_failures = 0;
+
+inline void expect(bool ok, std::string_view what, const std::source_location& loc = std::source_location::current()) {
+    if (ok)
+        return;
+
+    std::println(stderr, "{}:{}: failed: {}", loc.file_name(), loc.line(), what);
+    g_failures++;
+}
+
+#define EXPECT(expr) expect(!!(expr), #expr)
+
+// exit code for main()
+inline int testResult(std::string_view name) {
+    if (g_failures == 0)
+        std::println("{}: all passed", name);
+    else
+        std::println(stderr, "{}: {} check(s) failed", name, g_failures);
+
+    return g_failures == 0 ? 0 : 1;
+}
+
+inline double msSince(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
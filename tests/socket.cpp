@@ -0,0 +1,203 @@
+#include "../src/ipc/HyprlandSocket.hpp"
+#include "HeadlessBackend.hpp"
+#include "shared.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <optional>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <hyprutils/memory/Casts.hpp>
+
+using namespace std::chrono_literals;
+
+constexpr const char* HIS = "hyprpaper-test";
+
+// a stand-in for hyprland: every connection is handed to the next serve()
+static int listenAt(const std::string& path) {
+    const auto FD = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    sockaddr_un addr = {0};
+    addr.sun_family  = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (FD < 0 || bind(FD, rc<sockaddr*>(&addr), SUN_LEN(&addr)) < 0 || listen(FD, 4) < 0) {
+        if (FD >= 0)
+            close(FD);
+        return -1;
+    }
+
+    return FD;
+}
+
+static std::thread serve(int listenFd, std::function<void(int)>&& fn) {
+    return std::thread([listenFd, fn = std::move(fn)] {
+        const auto FD = accept(listenFd, nullptr, nullptr);
+        if (FD < 0)
+            return;
+
+        fn(FD);
+        close(FD);
+    });
+}
+
+static std::string readCommand(int fd) {
+    char buf[256];
+    const auto LEN = read(fd, buf, sizeof(buf));
+    return LEN > 0 ? std::string{buf, sc<size_t>(LEN)} : "";
+}
+
+static void respond(int fd, const std::string& data) {
+    ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+}
+
+struct SResult {
+    std::optional<HyprlandSocket::Reply> reply;
+    int                                  calls = 0;
+};
+
+static SP<HyprlandSocket::CRequest> request(const SP<CHeadlessBackend>& backend, SResult& result) {
+    return HyprlandSocket::getFromSocket(backend, "/splash", [&result](HyprlandSocket::Reply reply) {
+        result.reply = std::move(reply);
+        result.calls++;
+    });
+}
+
+// real time, the server is a thread
+static void waitFor(const SP<CHeadlessBackend>& backend, const SResult& result) {
+    while (!result.reply && backend->poll(2000ms)) {
+        ;
+    }
+
+    backend->dispatch();
+}
+
+static void testNoServer(const SP<CHeadlessBackend>& backend) {
+    SResult    result;
+    const auto REQUEST = request(backend, result);
+
+    // nothing listening, that's known right away
+    EXPECT(result.calls == 1);
+    EXPECT(result.reply && !*result.reply);
+}
+
+static void testChunked(const SP<CHeadlessBackend>& backend, int listenFd) {
+    const std::string REPLY = "Hyprland says " + std::string(100000, 'x') + " hi";
+    std::string       command;
+
+    // the reply dribbles in, split at odd places
+    auto server = serve(listenFd, [&command, &REPLY](int fd) {
+        command = readCommand(fd);
+
+        for (size_t pos = 0; pos < REPLY.size(); pos += 30000) {
+            respond(fd, REPLY.substr(pos, 30000));
+            std::this_thread::sleep_for(10ms);
+        }
+    });
+
+    SResult    result;
+    const auto REQUEST = request(backend, result);
+
+    waitFor(backend, result);
+    server.join();
+
+    EXPECT(command == "/splash");
+    EXPECT(result.calls == 1);
+    EXPECT(result.reply && *result.reply && **result.reply == REPLY);
+}
+
+static void testPeerReset(const SP<CHeadlessBackend>& backend, int listenFd) {
+    // half a reply, then gone without reading the command, which resets the connection
+    auto server = serve(listenFd, [](int fd) {
+        respond(fd, "Hyprl");
+        std::this_thread::sleep_for(10ms);
+    });
+
+    SResult    result;
+    const auto REQUEST = request(backend, result);
+
+    waitFor(backend, result);
+    server.join();
+
+    EXPECT(result.calls == 1);
+    EXPECT(result.reply && !*result.reply);
+}
+
+static void testTimeout(const SP<CHeadlessBackend>& backend, int listenFd) {
+    // reads the command and never answers, until the client hangs up
+    auto server = serve(listenFd, [](int fd) {
+        readCommand(fd);
+        readCommand(fd);
+    });
+
+    SResult    result;
+    const auto REQUEST = request(backend, result);
+
+    backend->advance(4s);
+    EXPECT(!result.reply);
+
+    backend->advance(1s);
+    EXPECT(result.calls == 1);
+    EXPECT(result.reply && !*result.reply);
+
+    // the connection is closed once the request gave up, which lets the server go
+    backend->dispatch();
+    server.join();
+
+    backend->advance(10s);
+    EXPECT(result.calls == 1);
+}
+
+static void testDropped(const SP<CHeadlessBackend>& backend, int listenFd) {
+    auto server = serve(listenFd, [](int fd) {
+        readCommand(fd);
+        respond(fd, "too late");
+    });
+
+    SResult result;
+    auto    req = request(backend, result);
+
+    // nobody wants the reply anymore
+    req.reset();
+    backend->dispatch();
+    server.join();
+
+    backend->poll(100ms);
+    backend->advance(10s);
+    EXPECT(result.calls == 0);
+}
+
+int main() {
+    const auto DIR = std::filesystem::temp_directory_path() / std::format("hyprpaper-test-socket-{}", getpid());
+    std::filesystem::create_directories(DIR / "hypr" / HIS);
+
+    // read once, before the first request
+    setenv("XDG_RUNTIME_DIR", DIR.c_str(), 1);
+    setenv("HYPRLAND_INSTANCE_SIGNATURE", HIS, 1);
+
+    const auto BACKEND = makeShared<CHeadlessBackend>();
+
+    testNoServer(BACKEND);
+
+    const auto LISTEN = listenAt((DIR / "hypr" / HIS / ".socket.sock").string());
+    EXPECT(LISTEN >= 0);
+
+    if (LISTEN >= 0) {
+        testChunked(BACKEND, LISTEN);
+        testPeerReset(BACKEND, LISTEN);
+        testTimeout(BACKEND, LISTEN);
+        testDropped(BACKEND, LISTEN);
+
+        close(LISTEN);
+    }
+
+    std::filesystem::remove_all(DIR);
+
+    return testResult("socket");
+}
@@ -0,0 +1,159 @@
+#include "../src/config/WallpaperMatcher.hpp"
+#include "../src/image/DecodePool.hpp"
+#include "../src/helpers/Logger.hpp"
+#include "../src/helpers/Stats.hpp"
+#include "../src/ui/UI.hpp"
+#include "HeadlessBackend.hpp"
+#include "Png.hpp"
+#include "shared.hpp"
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <unistd.h>
+
+constexpr const char* OUTPUT = "HEADLESS-0";
+
+static void settle(CHeadlessBackend& backend) {
+    backend.dispatch();
+
+    while (g_decodePool->pending() > 0) {
+        backend.poll(std::chrono::milliseconds(100));
+    }
+}
+
+static CConfigManager::SSetting image(const std::string& path) {
+    auto playlist = makeShared<CPlaylist>();
+    playlist->add(path);
+    return CConfigManager::SSetting{.monitor = OUTPUT, .fitMode = "cover", .paths = playlist};
+}
+
+static CConfigManager::SSetting gradient() {
+    return CConfigManager::SSetting{.monitor = OUTPUT, .fitMode = "cover", .fill = CConfigManager::SFill{.colors = {0xFF000000, 0xFFFFFFFF}}};
+}
+
+static void testUpdateKeepsWindow(CHeadlessBackend& backend, const std::vector<std::string>& images) {
+    const auto TARGET  = g_ui->targets().at(0);
+    const auto WINDOWS = backend.m_counters->windows;
+
+    for (const auto& setting : {image(images[1]), gradient(), image(images[0])}) {
+        g_matcher->addState(CConfigManager::SSetting{setting});
+        settle(backend);
+
+        EXPECT(g_ui->targets().size() == 1);
+        EXPECT(g_ui->targets().at(0) == TARGET);
+        EXPECT(backend.m_counters->windows == WINDOWS);
+    }
+
+    EXPECT(TARGET->m_lastPath == images[0]);
+}
+
+// Nothing is redrawn unless a timer fired: a still image sets none, a slideshow one per
+// tick and one per transition frame.
+static void testIdle(CHeadlessBackend& backend, const std::vector<std::string>& images) {
+    g_matcher->addState(image(images[0]));
+    settle(backend);
+
+    auto commits = backend.m_counters->commits;
+    auto wakeups = backend.m_counters->wakeups;
+
+    backend.advance(std::chrono::hours(1), [&backend] { settle(backend); });
+    EXPECT(backend.m_counters->commits == commits);
+    EXPECT(backend.m_counters->wakeups == wakeups);
+
+    auto playlist = makeShared<CPlaylist>();
+    for (const auto& i : images) {
+        playlist->add(i);
+    }
+
+    g_matcher->addState(CConfigManager::SSetting{.monitor = OUTPUT, .fitMode = "cover", .paths = playlist, .timeout = 60, .transition = "crossfade"});
+    settle(backend);
+
+    const auto SWAPS       = g_stats->slideshow.swaps.load();
+    uint64_t   idleCommits = 0;
+
+    for (int i = 0; i < 3600; ++i) {
+        commits = backend.m_counters->commits;
+        wakeups = backend.m_counters->wakeups;
+
+        backend.advance(std::chrono::seconds(1), [&backend] { settle(backend); });
+
+        if (backend.m_counters->wakeups == wakeups)
+            idleCommits += backend.m_counters->commits - commits;
+    }
+
+    EXPECT(idleCommits == 0);
+    // a swap every minute
+    EXPECT(g_stats->slideshow.swaps.load() - SWAPS >= 59 && g_stats->slideshow.swaps.load() - SWAPS <= 60);
+}
+
+static void testResize(CHeadlessBackend& backend, const std::vector<std::string>& images) {
+    const auto TARGET  = g_ui->targets().at(0);
+    const auto WINDOWS = backend.m_counters->windows;
+
+    g_matcher->addState(image(images[0]));
+    settle(backend);
+    EXPECT(TARGET->residentBytes() == 1920UZ * 1080 * 4);
+
+    // decoded again for the new mode, into the same window
+    backend.resizeOutput(OUTPUT, {960, 540});
+    settle(backend);
+    EXPECT(TARGET->residentBytes() == 960UZ * 540 * 4);
+    EXPECT(TARGET->m_lastPath == images[0]);
+
+    // and a gradient keeps the output's aspect
+    g_matcher->addState(gradient());
+    settle(backend);
+    EXPECT(TARGET->residentBytes() == 256UZ * 144 * 4);
+
+    backend.resizeOutput(OUTPUT, {2560, 1080});
+    settle(backend);
+    EXPECT(TARGET->residentBytes() == 256UZ * 108 * 4);
+
+    EXPECT(g_ui->targets().at(0) == TARGET);
+    EXPECT(backend.m_counters->windows == WINDOWS);
+}
+
+int main() {
+    const auto DIR = std::filesystem::temp_directory_path() / std::format("hyprpaper-test-ui-{}", getpid());
+    std::filesystem::create_directories(DIR);
+
+    std::vector<std::string> images;
+    for (int i = 0; i < 2; ++i) {
+        const auto PATH = (DIR / std::format("{}.png", i)).string();
+        if (writePng(PATH, 1920, 1080, 0x336699))
+            images.emplace_back(PATH);
+    }
+
+    std::ofstream(DIR / "hyprpaper.conf") << "splash = false\nipc = false\ndisk_cache = 0\n";
+
+    g_logger->setLogLevel(LOG_ERR);
+    g_config = makeUnique<CConfigManager>((DIR / "hyprpaper.conf").string());
+
+    const auto BACKEND = makeShared<CHeadlessBackend>();
+    g_ui               = makeUnique<CUI>();
+
+    EXPECT(images.size() == 2);
+
+    if (images.size() == 2 && g_config->init() && g_ui->init(BACKEND)) {
+        g_matcher->addState(image(images[0]));
+        BACKEND->addOutput(OUTPUT);
+        settle(*BACKEND);
+
+        EXPECT(g_ui->targets().size() == 1);
+
+        if (!g_ui->targets().empty()) {
+            testUpdateKeepsWindow(*BACKEND, images);
+            testIdle(*BACKEND, images);
+            testResize(*BACKEND, images);
+        }
+    } else
+        EXPECT(!"setup failed");
+
+    g_ui.reset();
+    g_config.reset();
+
+    std::filesystem::remove_all(DIR);
+
+    return testResult("ui");
+}